@@ -0,0 +1,54 @@
+#include "bench.hh"
+
+#include <cstdio>
+
+namespace bench {
+	void runner::run(std::string_view name,
+	                 std::size_t bytes,
+	                 benchmark_fn const& fn) {
+		if (!opts_.filter.empty() &&
+		    name.find(opts_.filter) == std::string_view::npos)
+			return;
+
+		using clock = std::chrono::steady_clock;
+
+		result res{};
+		res.name.assign(name);
+		res.bytes = bytes;
+
+		// warm up caches and any lazily built tables first
+		(void)fn();
+
+		auto const allocs = allocations();
+		auto const start = clock::now();
+		do {
+			res.tokens += fn();
+			++res.iterations;
+			res.elapsed = clock::now() - start;
+		} while (res.elapsed < opts_.min_time);
+		res.allocations = allocations() - allocs;
+
+		report(res);
+	}
+
+	void report_header() {
+		std::printf("%-32s %10s %10s %12s %8s\n", "benchmark", "MB/s", "Mtok/s",
+		            "allocs/MB", "runs");
+	}
+
+	void report(result const& res) {
+		auto const seconds = res.elapsed.count();
+		auto const megabytes =
+		    static_cast<double>(res.bytes) *
+		    static_cast<double>(res.iterations) / 1'000'000.0;
+		auto const mb_per_s = megabytes / seconds;
+		auto const mtok_per_s =
+		    static_cast<double>(res.tokens) / 1'000'000.0 / seconds;
+		auto const allocs_per_mb =
+		    static_cast<double>(res.allocations) / megabytes;
+
+		std::printf("%-32s %10.2f %10.2f %12.1f %8zu\n", res.name.c_str(),
+		            mb_per_s, mtok_per_s, allocs_per_mb, res.iterations);
+		std::fflush(stdout);
+	}
+}
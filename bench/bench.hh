@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace bench {
+	// Keeps the optimizer from folding loops whose result does not depend
+	// on the work done inside, like counting matches of `ch`.
+	template <typename Value>
+	inline void do_not_optimize(Value const& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		(void)value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+
+	// Number of calls to global operator new so far; replaced in main.cc.
+	std::size_t allocations() noexcept;
+
+	struct options {
+		std::chrono::duration<double> min_time{0.5};
+		std::string filter{};
+	};
+
+	// A single run over `bytes` of input, returning the number of tokens
+	// (or other items) it has seen.
+	using benchmark_fn = std::function<std::size_t()>;
+
+	struct result {
+		std::string name{};
+		std::size_t bytes{};
+		std::size_t tokens{};
+		std::size_t allocations{};
+		std::size_t iterations{};
+		std::chrono::duration<double> elapsed{};
+	};
+
+	class runner {
+	public:
+		explicit runner(options const& opts) : opts_{opts} {}
+
+		void run(std::string_view name, std::size_t bytes, benchmark_fn const& fn);
+
+	private:
+		options opts_;
+	};
+
+	void report_header();
+	void report(result const& res);
+
+	void run_cell(runner&);
+	void run_hilite(runner&, std::vector<std::string> const& files);
+}
@@ -0,0 +1,75 @@
+#include "bench.hh"
+
+#include <cell/ascii.hh>
+#include <cell/character.hh>
+#include <cell/context.hh>
+#include <cell/operators.hh>
+#include <cell/parser.hh>
+#include <cell/repeat_operators.hh>
+#include <cell/special.hh>
+#include <cell/string.hh>
+
+namespace bench {
+	namespace {
+		using namespace cell;
+
+		constexpr std::size_t input_size = 1024 * 1024;
+
+		struct no_value {};
+		using iterator = std::string::const_iterator;
+		using context_t = cell::context<iterator, nothing, no_value>;
+
+		std::string repeated(std::string_view unit) {
+			std::string result;
+			result.reserve(input_size + unit.size());
+			while (result.size() < input_size)
+				result.append(unit);
+			return result;
+		}
+
+		// Runs `parser` over the input for as long as it matches, counting
+		// the matches; the input is built so that the whole of it matches.
+		template <typename Parser>
+		void add(runner& run,
+		         std::string_view name,
+		         std::string input,
+		         Parser const& parser) {
+			auto const bytes = input.size();
+			run.run(name, bytes, [input = std::move(input), parser] {
+				auto first = input.begin();
+				auto const last = input.end();
+				context_t ctx{empty, {}};
+				std::size_t count{};
+				while (first != last && parser.parse(first, last, ctx)) {
+					do_not_optimize(first);
+					++count;
+				}
+				return count;
+			});
+		}
+	}  // namespace
+
+	void run_cell(runner& run) {
+		static std::string const keyword = "namespace";
+
+		// clang-format off
+		add(run, "cell/ch", repeated("int main() { return 0; }\n"), ch);
+		add(run, "cell/ch('x')", repeated("x"), as_parser('x'));
+		add(run, "cell/ch(\"set\")", repeated("+-*/%^&|"), ch("+-*/%^&|"));
+		add(run, "cell/alpha", repeated("abcdefghijklmnopqrstuvwxyz"), alpha);
+		add(run, "cell/lit", repeated("import"), lit("import"));
+		add(run, "cell/string_token", repeated(keyword), string_token{keyword});
+		add(run, "cell/*alpha", repeated("identifier "), *alpha >> ' ');
+		add(run, "cell/+alnum", repeated("identifier42 "), +alnum >> ' ');
+		add(run, "cell/-sign>>+digit", repeated("-12345 67890 "), -ch('-') >> +digit >> ' ');
+		add(run, "cell/repeat(4)", repeated("\\u00e9"), '\\' >> ch('u') >> repeat(4)(xdigit));
+		add(run, "cell/alternative",
+			repeated("if else while for return value "),
+			(lit("if") | lit("else") | lit("while") | lit("for") | lit("return") | +alpha) >> ' ');
+		add(run, "cell/difference", repeated("a line of text\n"), (ch - eol) | eol);
+		add(run, "cell/ahead",
+			repeated("/* block */ code "),
+			(ahead(lit("/*")) >> lit("/*") >> *(ch - lit("*/")) >> lit("*/")) | ch);
+		// clang-format on
+	}
+}
@@ -0,0 +1,118 @@
+#include "corpus.hh"
+
+#include <cstdio>
+#include <fs/file.hh>
+
+namespace bench {
+	namespace {
+		constexpr std::size_t corpus_size = 1024 * 1024;
+
+		template <typename Generator>
+		std::string generate(Generator&& next) {
+			std::string result;
+			result.reserve(corpus_size + 4096);
+			for (unsigned index = 0; result.size() < corpus_size; ++index)
+				next(result, index);
+			return result;
+		}
+
+		std::string read(fs::path const& path) {
+			auto const bytes = fs::fopen(path, "rb").read();
+			return {bytes.data(), bytes.size()};
+		}
+	}  // namespace
+
+	std::string comment_heavy() {
+		return generate([](std::string& out, unsigned index) {
+			auto const id = std::to_string(index);
+			out.append("/**\n * Returns the value of item #" + id + ".\n *\n");
+			out.append(
+			    " * The comment is longer than the code it describes, with "
+			    "`markup`, \"quotes\", 'apostrophes' and a // nested line "
+			    "comment marker.\n */\n");
+			out.append("int item_" + id + "(); // trailing comment " + id +
+			           "\n");
+			out.append(
+			    "/* short */ int /* inside */ value_" + id +
+			    " = 0; /* multi\n   line */\n");
+		});
+	}
+
+	std::string raw_string_heavy() {
+		return generate([](std::string& out, unsigned index) {
+			auto const id = std::to_string(index);
+			out.append("auto const text_" + id + " = R\"(plain \"quoted\" \\n " +
+			           id + ")\";\n");
+			out.append("auto const json_" + id +
+			           " = u8R\"json({\n\t\"key\": \"value)\",\n\t\"n\": " + id +
+			           "\n})json\";\n");
+			out.append("auto const regex_" + id +
+			           " = LR\"re(^\\s*(\\w+)\\s*=\\s*\"([^\"]*)\"$)re\"s;\n");
+		});
+	}
+
+	std::string long_lines() {
+		// four lines of 256 KiB each, one of expressions, one of a string
+		// literal, one of an initializer list and one of a macro definition
+		// spliced with backslash-newlines every few tokens
+		static constexpr std::size_t line_size = corpus_size / 4;
+		std::string out;
+		out.reserve(corpus_size + 4096);
+
+		out.append("auto const sum = 0");
+		for (unsigned index = 0; out.size() < line_size; ++index)
+			out.append(" + value_" + std::to_string(index) + " * 0x1F");
+		out.append(";\n");
+
+		auto const start = out.size();
+		out.append("char const* text = \"");
+		while (out.size() - start < line_size)
+			out.append("long line of text with \\\"escapes\\\"\\t ");
+		out.append("\";\n");
+
+		auto const list = out.size();
+		out.append("int const table[] = {");
+		for (unsigned index = 0; out.size() - list < line_size; ++index)
+			out.append(std::to_string(index) + "'000u, ");
+		out.append("};\n");
+
+		auto const macro = out.size();
+		out.append("#define LONG_MACRO(x) ");
+		for (unsigned index = 0; out.size() - macro < line_size; ++index)
+			out.append("x##" + std::to_string(index) + " \\\n");
+		out.append("\n");
+
+		return out;
+	}
+
+	std::string module_heavy() {
+		return generate([](std::string& out, unsigned index) {
+			auto const id = std::to_string(index);
+			out.append("module;\n#include <header_" + id + ".hh>\n");
+			out.append("export module lib.part_" + id + ":impl;\n");
+			out.append("import std;\nexport import lib.base;\nimport :types;\n");
+			out.append("import \"local_" + id + ".hh\";\n");
+			out.append("export int f_" + id + "() { return " + id + "; }\n");
+		});
+	}
+
+	std::vector<corpus> load_corpora(std::vector<std::string> const& files) {
+		std::vector<corpus> result{};
+		for (auto const& file : files) {
+			auto text = read(file);
+			if (text.empty()) {
+				std::fprintf(stderr, "c++modules-bench: cannot read %s\n",
+				             file.c_str());
+				continue;
+			}
+			auto name = fs::path{file}.filename().string();
+			result.push_back({std::move(name), std::move(text)});
+		}
+
+		result.push_back({"comments", comment_heavy()});
+		result.push_back({"raw-strings", raw_string_heavy()});
+		result.push_back({"long-lines", long_lines()});
+		result.push_back({"modules", module_heavy()});
+		return result;
+	}
+}
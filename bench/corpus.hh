@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+	struct corpus {
+		std::string name;
+		std::string text;
+	};
+
+	// Synthetic sources, built the same way on every run. Each one is
+	// roughly 1 MiB and stresses a single part of the lexer.
+	std::string comment_heavy();
+	std::string raw_string_heavy();
+	std::string long_lines();
+	std::string module_heavy();
+
+	std::vector<corpus> load_corpora(std::vector<std::string> const& files);
+}
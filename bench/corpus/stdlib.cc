@@ -0,0 +1,14 @@
+// Preprocessed by the bench target to get a large, realistic translation
+// unit; the exact text depends on the standard library in use.
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <ranges>
+#include <string>
+#include <vector>
+
+int main() {
+	std::vector<std::string> words{"one", "two", "three"};
+	for (auto const& word : words | std::views::reverse)
+		std::cout << word << '\n';
+}
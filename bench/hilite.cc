@@ -0,0 +1,64 @@
+#include "bench.hh"
+#include "corpus.hh"
+
+#include <cxx/scanner.hh>
+#include <hilite/ansi.hh>
+#include <hilite/cxx.hh>
+#include <hilite/html.hh>
+
+namespace bench {
+	namespace {
+		struct token_counter : hl::callback {
+			std::size_t count{};
+			void on_line(std::size_t,
+			             std::size_t,
+			             const hl::tokens& highlights) override {
+				count += highlights.size();
+			}
+		};
+
+		struct null_output : hl::output {
+			void write(std::string_view) override {}
+		};
+
+		std::size_t tokenize(std::string_view text) {
+			token_counter counter{};
+			hl::cxx::tokenize(text, counter);
+			return counter.count;
+		}
+	}  // namespace
+
+	void run_hilite(runner& run, std::vector<std::string> const& files) {
+		auto const corpora = load_corpora(files);
+
+		for (auto const& [name, text] : corpora) {
+			std::string_view const view{text};
+			auto const tokens = tokenize(view);
+
+			run.run("tokenize/" + name, view.size(),
+			        [view] { return tokenize(view); });
+
+			run.run("scan/" + name, view.size(), [view, tokens] {
+				auto const unit = cxx::scan(view);
+				(void)unit;
+				return tokens;
+			});
+
+			run.run("render-html/" + name, view.size(), [view, tokens] {
+				null_output out{};
+				hl::html::renderer html{view, out, hl::cxx::token_to_string};
+				hl::cxx::tokenize(view, html);
+				html.finish();
+				return tokens;
+			});
+
+			run.run("render-ansi/" + name, view.size(), [view, tokens] {
+				null_output out{};
+				hl::ansi::renderer ansi{view, out};
+				hl::cxx::tokenize(view, ansi);
+				ansi.finish();
+				return tokens;
+			});
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#include "bench.hh"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<std::size_t> allocation_count{};
+
+	void* counted_alloc(std::size_t size) {
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+		if (!size) size = 1;
+		if (auto ptr = std::malloc(size)) return ptr;
+		throw std::bad_alloc{};
+	}
+
+	void usage() {
+		std::fputs(
+		    "usage: c++modules-bench [--time <seconds>] [--filter <text>] "
+		    "[<file>...]\n\n"
+		    "Files are tokenized and scanned next to the built-in corpora.\n",
+		    stderr);
+	}
+}  // namespace
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+std::size_t bench::allocations() noexcept {
+	return allocation_count.load(std::memory_order_relaxed);
+}
+
+int main(int argc, char** argv) {
+	bench::options opts{};
+	std::vector<std::string> files{};
+
+	for (int index = 1; index < argc; ++index) {
+		std::string_view const arg{argv[index]};
+		if (arg == "--time" && index + 1 < argc) {
+			opts.min_time = std::chrono::duration<double>{
+			    std::strtod(argv[++index], nullptr)};
+		} else if (arg == "--filter" && index + 1 < argc) {
+			opts.filter = argv[++index];
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else if (arg.starts_with("-")) {
+			usage();
+			return 1;
+		} else {
+			files.emplace_back(arg);
+		}
+	}
+
+	bench::runner run{opts};
+	bench::report_header();
+	bench::run_cell(run);
+	bench::run_hilite(run, files);
+}
@@ -0,0 +1,489 @@
+#pragma once
+
+#include "hilite/cxx.hh"
+#include "hilite/hilite_impl.hh"
+
+#include "cell/ascii.hh"
+#include "cell/character.hh"
+#include "cell/context.hh"
+#include "cell/operators.hh"
+#include "cell/parser.hh"
+#include "cell/repeat_operators.hh"
+#include "cell/rule.hh"
+#include "cell/special.hh"
+#include "cell/string.hh"
+#include "cell/tokens.hh"
+#include "cell/unicode.hh"
+
+#include <iterator>
+#include <memory>
+#include <string_view>
+
+namespace hl::cxx::parser::callbacks {
+	template <typename Iterator>
+	struct cxx_grammar_value : grammar_value<Iterator> {
+		using grammar_value<Iterator>::grammar_value;
+		bool is_raw{false};
+	};
+
+	template <typename Context>
+	auto& _is_raw_string(Context& context) {
+		return _val(context).is_raw;
+	}
+
+	RULE_EMIT(newline, token::newline)
+	RULE_EMIT(deleted_eol, token::deleted_newline)
+	RULE_EMIT(block_comment, token::block_comment)
+	RULE_EMIT(line_comment, token::line_comment)
+	RULE_EMIT(ws, token::whitespace)
+	RULE_EMIT(character_literal, token::character)
+	RULE_EMIT(string_literal,
+	          _is_raw_string(context) ? token::raw_string : token::string)
+	RULE_EMIT(punctuator, token::punctuator)
+	RULE_EMIT(pp_identifier, token::preproc_identifier)
+	RULE_EMIT(macro_name, token::macro_name)
+	RULE_EMIT(macro_arg, token::macro_arg)
+	RULE_EMIT(macro_va_args, token::macro_va_args)
+	RULE_EMIT(replacement, token::macro_replacement)
+	RULE_EMIT(control_line, token::preproc)
+	RULE_EMIT(system_header, token::system_header_name)
+	RULE_EMIT(local_header, token::local_header_name)
+	RULE_EMIT(pp_number, token::number)
+	RULE_EMIT(escaped, token::escape_sequence)
+	RULE_EMIT(ucn, token::universal_character_name)
+	RULE_EMIT(pp_define_arg_list, token::macro_arg_list)
+
+	RULE_EMIT(char_encoding, token::char_encoding)
+	RULE_EMIT(char_delim, token::char_delim)
+	RULE_EMIT(char_udl, token::char_udl)
+
+	RULE_EMIT(string_encoding, token::string_encoding)
+	RULE_EMIT(string_delim, token::string_delim)
+	RULE_EMIT(string_udl, token::string_udl)
+
+	RULE_EMIT(module_name, token::module_name)
+	RULE_EMIT(module_export, token::module_export)
+	RULE_EMIT(import, token::module_import)
+	RULE_EMIT(module_decl, token::module_decl)
+	RULE_EMIT(module_part_marker, token::punctuator)
+
+	RULE_MAP(identifier) { _emit(context, token::identifier); }
+}  // namespace hl::cxx::parser::callbacks
+
+namespace hl::cxx::parser {
+	using namespace hl::cxx::parser::callbacks;
+	using namespace cell;
+
+	static constexpr auto operator""_ident(const char* str, size_t len) {
+		return string_token{std::string_view(str, len)}[on_identifier];
+	}
+
+	static constexpr auto operator""_pp_ident(const char* str, size_t len) {
+		return string_token{std::string_view(str, len)}[on_pp_identifier];
+	}
+
+	// clang-format off
+	constexpr auto line_comment =
+		("//" >> *(ch - eol))
+		;
+
+	constexpr auto block_comment =
+		(
+		"/*" >> *(
+			(ch - '*' - eol)
+			| ('*' >> !ch('/'))
+			| eol									[on_newline]
+			) >> "*/"
+		)
+		;
+
+	constexpr auto SP_char =
+		inlspace
+		| line_comment
+		| block_comment
+		;
+
+	constexpr auto SP =
+		*SP_char
+		;
+
+	constexpr auto mandatory_SP =
+		+SP_char
+		;
+
+	constexpr auto UCN_value =
+		('u' >> repeat(4)(xdigit))
+		| ('U' >> repeat(8)(xdigit))
+		;
+
+	constexpr auto nondigit =
+		'_'
+		| alpha
+		;
+
+	constexpr auto ident_nondigit =
+		'_'
+		| alpha
+		| ('\\' >> UCN_value)
+		| xid_start
+		;
+
+	constexpr auto ident_continue =
+		'_'
+		| alnum
+		| ('\\' >> UCN_value)
+		| xid_continue
+		;
+
+	constexpr auto sign = ch("+-");
+
+	constexpr auto header_name =
+		('<' >> +(ch - eol - '>') >> '>')			[on_system_header]
+		| ('"' >> +(ch - eol - '"') >> '"')			[on_local_header]
+		;
+
+	constexpr auto pp_number =
+		-ch('.') >> digit >> *(
+			ident_continue
+			| ('\'' >> (digit | nondigit))
+			| (ch("eEpP") >> sign)
+			)
+		;
+	// clang-format on
+
+	// ident_nondigit >> *ident_continue, with runs of [A-Za-z0-9_] taken
+	// in blocks, whenever the input is contiguous
+	struct cxx_identifier_parser
+	    : cell::character_parser<cxx_identifier_parser> {
+		constexpr cxx_identifier_parser() = default;
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			auto const save = first;
+			if (!ident_nondigit.parse(first, last, ctx)) {
+				first = save;
+				return false;
+			}
+
+			while (true) {
+				this->filter(first, last, ctx);
+				if (first == last) break;
+
+				if constexpr (std::contiguous_iterator<Iterator>) {
+					auto const ptr = std::to_address(first);
+					auto const end = cell::unicode::skip_ascii_word(
+					    ptr, ptr + (last - first));
+					if (end != ptr) {
+						first += end - ptr;
+						continue;
+					}
+				}
+
+				if (!ident_continue.parse(first, last, ctx)) break;
+			}
+			return true;
+		}
+	};
+
+	constexpr auto identifier = cxx_identifier_parser{};
+
+	template <char C>
+	struct cxx_char_parser : cell::character_parser<cxx_char_parser<C>> {
+		constexpr cxx_char_parser() = default;
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			this->filter(first, last, ctx);
+
+			if (first == last) return false;
+
+			auto save = first;
+
+			{
+				cell::action_state disable_actions{};
+				if (eol.parse(first, last, ctx)) {
+					first = save;
+					return false;
+				}
+			}
+
+			if (*first == C) {
+				first = save;
+				return false;
+			}
+
+			bool escaped = *first == '\\';
+			++first;
+
+			if (!escaped) return true;
+
+			this->filter(first, last, ctx);
+
+			if (first == last) {
+				first = save;
+				return false;
+			}
+
+			auto const escaped_ch = *first;
+			++first;
+
+			switch (escaped_ch) {
+				case 'u':
+					if (repeat(4)(xdigit).parse(first, last, ctx)) {
+						if (cell::action_state::enabled()) {
+							_setrange(save, first, ctx);
+							on_ucn(ctx);
+						}
+						return true;
+					}
+					break;
+				case 'U':
+					if (repeat(8)(xdigit).parse(first, last, ctx)) {
+						if (cell::action_state::enabled()) {
+							_setrange(save, first, ctx);
+							on_ucn(ctx);
+						}
+						return true;
+					}
+					break;
+				case 'x':
+					if ((+xdigit).parse(first, last, ctx)) {
+						if (cell::action_state::enabled()) {
+							_setrange(save, first, ctx);
+							on_escaped(ctx);
+						}
+						return true;
+					}
+					break;
+				case '0':
+					if ((*odigit).parse(first, last, ctx)) {
+						if (cell::action_state::enabled()) {
+							_setrange(save, first, ctx);
+							on_escaped(ctx);
+						}
+						return true;
+					}
+					break;
+				default:
+					if (cell::action_state::enabled()) {
+						_setrange(save, first, ctx);
+						on_escaped(ctx);
+					}
+					return true;
+			}
+
+			first = save;
+			return false;
+		}
+	};
+
+	// clang-format off
+	constexpr auto c_char = cxx_char_parser<'\''>{};
+	constexpr auto s_char = cxx_char_parser<'"'>{};
+
+	constexpr auto d_char =
+		ch - ch(" ()\\\t\v\f\r\n\"")
+		;
+
+	constexpr auto encoding_prefix =
+		lit("u8")
+		| "u"
+		| "U"
+		| "L"
+		;
+
+	constexpr auto character_literal =
+		-(encoding_prefix)
+		>> ch('\'') >> +c_char >> ch('\'')
+		>> -(identifier)
+		;
+	// clang-format on
+
+	struct cxx_string_parser : cell::parser<cxx_string_parser> {
+		constexpr cxx_string_parser() = default;
+		template <typename Iterator>
+		using range_t = std::pair<Iterator, Iterator>;
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			Iterator start_delim_end, finish_delim_begin;
+
+			_is_raw_string(ctx) = false;
+
+			auto get_quot_end = [&start_delim_end](auto& ctx) {
+				start_delim_end = _getrange(ctx).second;
+			};
+			auto get_quot_start = [&finish_delim_begin](auto& ctx) {
+				finish_delim_begin = _getrange(ctx).first;
+			};
+			auto c_string =
+			    (ch('"')[get_quot_end]) >> *s_char >> (ch('"')[get_quot_start]);
+			auto copy = first;
+			(void)encoding_prefix.parse(first, last, ctx);
+			auto result = false;
+			auto is_raw = ch('R').parse(first, last, ctx);
+			if (is_raw)
+				result = parse_raw(first, last, ctx, start_delim_end,
+				                   finish_delim_begin);
+			else
+				result = c_string.parse(first, last, ctx);
+
+			if (!result) {
+				first = copy;
+				return false;
+			}
+
+			(void)identifier.parse(first, last, ctx);
+			return true;
+		}
+
+		template <typename Iterator, typename Context>
+		bool parse_raw(Iterator& first,
+		               const Iterator& last,
+		               Context& ctx,
+		               Iterator& start_delim_end,
+		               Iterator& finish_delim_begin) const {
+			if (!ch('"').parse(first, last, ctx)) return false;
+
+			_is_raw_string(ctx) = true;
+			auto const front_delim_start = first;
+			while (d_char.parse(first, last, ctx))
+				;
+			auto const front_delim_end = first;
+
+			if (!ch('(').parse(first, last, ctx)) return false;
+
+			start_delim_end = first;
+
+			while (first != last) {
+				while (first != last) {
+					static constexpr auto signaling_eol = eol[on_newline];
+					if (signaling_eol.parse(first, last, ctx)) continue;
+					auto copy = first;
+					if (ch(')').parse(first, last, ctx)) {
+						finish_delim_begin = copy;
+						break;
+					}
+					++first;
+				}
+				// while (first != last && !ch(')').parse(first, last, ctx))
+				// ++first;
+				if (!parse_end_delim(front_delim_start, front_delim_end, first,
+				                     last))
+					continue;
+
+				auto copy = first;
+				if (ch('"').parse(copy, last, ctx)) {
+					first = copy;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		template <typename Iterator>
+		bool parse_end_delim(Iterator delim_first,
+		                     const Iterator& delim_last,
+		                     Iterator& first,
+		                     const Iterator& last) const {
+			if (delim_first == delim_last) return true;
+
+			while ((delim_first != delim_last) && (first != last)) {
+				if (*delim_first != *first) return false;
+				++delim_first;
+				++first;
+			}
+			return true;
+		}
+	};
+
+	// Same as lit("...") | "<=>" | ... | ch("<>{}..."), but as a single
+	// type; a chain of 38 alternatives costs more to instantiate than the
+	// rest of the grammar taken together.
+	struct cxx_operator_parser : cell::parser<cxx_operator_parser> {
+		constexpr cxx_operator_parser() = default;
+
+		// clang-format off
+		static constexpr std::string_view multichar[] = {
+			"...", "<=>", "<<=", ">>=", "<<", ">>",
+			"<:", ":>", "<%", "%>", "%:%:", "%:",
+			"::", "->*", "->", ".*",
+			"+=", "-=", "*=", "/=", "%=", "^=", "&=", "|=",
+			"++", "--", "==", "!=", "<=", ">=", "&&", "||", "##",
+		};
+		// clang-format on
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			for (auto const& op : multichar) {
+				if (cell::string_token{op}.parse(first, last, ctx)) return true;
+			}
+			return ch("<>{}[]#()=;:?.~!+-*/%^&|,").parse(first, last, ctx);
+		}
+	};
+
+	// clang-format off
+	constexpr auto string_literal = cxx_string_parser{};
+
+	constexpr auto operators = cxx_operator_parser{};
+
+	constexpr auto preprocessing_token =
+		character_literal							[on_character_literal]
+		| string_literal							[on_string_literal]
+		| identifier								[on_identifier]
+		| pp_number									[on_pp_number]
+		| operators									[on_punctuator]
+		;
+	// clang-format on
+
+	struct deleted_eol_parser : cell::parser<deleted_eol_parser> {
+		constexpr deleted_eol_parser() = default;
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			auto const emit0 = first;
+			if (first != last && *first == '\\') {
+				++first;
+				auto const emit1 = first;
+				if (eol.parse(first, last, ctx)) {
+					if (cell::action_state::enabled()) {
+						_setrange(emit0, emit1, ctx);
+						on_deleted_eol(ctx);
+
+						_setrange(emit1, first, ctx);
+						on_newline(ctx);
+					}
+					return true;
+				};
+			}
+			return false;
+		}
+	};
+
+	constexpr auto deleted_eol = deleted_eol_parser{};
+
+	// Everything above is small and hot enough to be inlined into whatever
+	// uses it. Bigger parts of the grammar are hidden behind rules, each
+	// defined in its own translation unit; this keeps the type of
+	// preprocessing_file (and the time needed to compile it) in check.
+	using grammar_iterator = std::string_view::const_iterator;
+	using grammar_context = cell::context<grammar_iterator,
+	                                      deleted_eol_parser,
+	                                      cxx_grammar_value<grammar_iterator>>;
+	using grammar_rule = cell::rule<grammar_iterator, grammar_context>;
+	using grammar_rule_definition = grammar_rule::definition;
+
+	// preprocessing_token for the parts of the grammar, which are too cold to
+	// have it inlined (cxx.cc)
+	extern grammar_rule_definition const pp_token_def;
+	constexpr auto pp_token = grammar_rule{pp_token_def};
+
+	// #include, #define, #if and the rest of preprocessor directives, without
+	// the leading hash (preprocessor.cc)
+	extern grammar_rule_definition const pp_control_def;
+	constexpr auto pp_control = grammar_rule{pp_control_def};
+
+	// [export] module ...; and [export] import ...; (modules.cc)
+	extern grammar_rule_definition const module_directive_def;
+	constexpr auto module_directive = grammar_rule{module_directive_def};
+}  // namespace hl::cxx::parser
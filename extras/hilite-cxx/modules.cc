@@ -0,0 +1,60 @@
+#include "grammar.hh"
+
+namespace hl::cxx::parser {
+	// clang-format off
+	constexpr auto pp_module_name_ident =
+		identifier                                                          [on_identifier]
+		;
+
+	constexpr auto pp_qualified_name =
+		pp_module_name_ident >>
+			*(SP
+				>> ch('.')                                                  [on_punctuator]
+				>> SP
+				>> pp_module_name_ident)
+		;
+
+	constexpr auto pp_module_part_marker =
+		ch(':')                                                             [on_punctuator]
+		;
+
+	constexpr auto pp_module_ref =
+		(pp_qualified_name >> SP >>
+			pp_module_part_marker >> SP >> pp_qualified_name)               [on_module_name]
+		| pp_qualified_name                                                 [on_module_name]
+		| (pp_module_part_marker >> SP >> pp_qualified_name)                [on_module_name]
+		;
+
+	constexpr auto pp_import =
+		(
+			lit("import")
+			>> SP
+			>> (header_name
+				| pp_module_ref
+				)
+			>> SP >> *((pp_token - ch(';')) >> SP) >> ch(';')
+		)                                                                   [on_import]
+		;
+
+	constexpr auto pp_module =
+		(
+			lit("module")
+			>> SP
+			>> -pp_module_ref
+			>> SP
+			>> *((pp_token - ch(';')) >> SP)
+			>> ch(';')
+		)                                                                   [on_module_decl]
+		;
+
+	constexpr auto module_directive_grammar =
+		(lit("export") >> SP >> (pp_module | pp_import))                    [on_module_export]
+		| pp_module
+		| pp_import
+		;
+	// clang-format on
+
+	constexpr grammar_rule_definition module_directive_def =
+	    cell::define<grammar_iterator, grammar_context>(
+	        module_directive_grammar);
+}  // namespace hl::cxx::parser
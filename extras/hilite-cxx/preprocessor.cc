@@ -0,0 +1,128 @@
+#include "grammar.hh"
+
+namespace hl::cxx::parser {
+	// clang-format off
+	constexpr auto mSP = mandatory_SP;
+	constexpr auto __has_include_token =
+		"__has_include"_ident
+		>> SP
+		>> '('
+		>> SP >> (
+			header_name
+			| string_literal
+			| ('<'
+				>> SP
+				>> +((pp_token - '>') >> SP)
+				>> SP
+				>> '>'
+				)
+			)
+		>> SP
+		>> ')'
+		;
+
+	constexpr auto constant_expression =
+		+(
+			(
+			__has_include_token
+			| pp_token
+			)
+			>> SP
+		)
+		;
+
+	constexpr auto opt_pp_tokens =
+		-(mSP
+			>> pp_token
+			>> *(SP >> pp_token)
+			)
+		>> SP
+		;
+
+	constexpr auto pp_define_arg_list =
+		( '('
+			>> SP
+			>> (
+				lit("...")							[on_macro_va_args]
+				| identifier						[on_macro_arg]
+					>> *(
+						SP
+						>> ','
+						>> SP
+						>> identifier				[on_macro_arg]
+						)
+					>> -(
+						SP
+						>> ','
+						>> SP
+						>> lit("...")				[on_macro_va_args]
+						)
+				| eps
+				)
+			>> SP
+			>> ')'
+			)										[on_pp_define_arg_list]
+		;
+
+	constexpr auto pp_include =
+		"include"_pp_ident
+		>> SP
+		>> +((header_name | pp_token) >> SP)
+		;
+
+	constexpr auto pp_define =
+		"define"_pp_ident
+		>> mSP
+		>> identifier								[on_macro_name]
+		>> -pp_define_arg_list
+		>> SP
+		>> (*(pp_token >> SP))						[on_replacement]
+		;
+
+	constexpr auto pp_undef =
+		"undef"_pp_ident
+		>> mSP
+		>> identifier								[on_macro_name]
+		>> SP
+		;
+
+	constexpr auto pp_if =
+		"if"_pp_ident
+		>> mSP
+		>> constant_expression
+		;
+
+	constexpr auto pp_ifdef =
+		"ifdef"_pp_ident
+		>> mSP
+		>> identifier								[on_macro_name]
+		>> SP
+		;
+
+	constexpr auto pp_ifndef =
+		"ifndef"_pp_ident
+		>> mSP
+		>> identifier								[on_macro_name]
+		>> SP
+		;
+
+	constexpr auto pp_control_grammar =
+		pp_include
+		| pp_define
+		| pp_undef
+		| pp_ifdef
+		| pp_ifndef
+		| pp_if
+		| ("elif"_pp_ident >> mSP >> constant_expression)
+		| "else"_pp_ident >> SP
+		| "endif"_pp_ident >> SP
+		| ("line"_pp_ident >> mSP >> +(pp_token >> SP))
+		| ("error"_pp_ident >> opt_pp_tokens)
+		| ("pragma"_pp_ident >> opt_pp_tokens)
+		| opt_pp_tokens
+		;
+	// clang-format on
+
+	constexpr grammar_rule_definition pp_control_def =
+	    cell::define<grammar_iterator, grammar_context>(pp_control_grammar);
+}  // namespace hl::cxx::parser
@@ -269,7 +269,7 @@ namespace cell {
 		template <typename Iterator, typename Context>
 		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
 			this->filter(first, last, ctx);
-			if (first != last && is(*first)) {
+			if (first != last && is(static_cast<unsigned char>(*first))) {
 				++first;
 				return true;
 			}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "parser.hh"
+
+namespace cell {
+	// A rule is a non-template boundary inside of an expression template.
+	// The grammar behind it is reached through a plain function pointer, so
+	// the type of the rule does not depend on the type of the grammar. This
+	// allows a rule to be declared in a header, defined in a single .cc file
+	// and referenced (also recursively) before the definition is seen.
+	//
+	//     // grammar.hh
+	//     extern rule_definition<It, Ctx> const expr_def;
+	//     constexpr auto expr = rule<It, Ctx>{expr_def};
+	//
+	//     // expr.cc
+	//     constexpr auto expr_grammar = '(' >> expr >> ')' | ...;
+	//     constexpr rule_definition<It, Ctx> expr_def = define<It, Ctx>(expr_grammar);
+	template <typename Iterator, typename Context>
+	struct rule_definition {
+		using parse_fn = bool (*)(void const*,
+		                          Iterator&,
+		                          const Iterator&,
+		                          Context&);
+
+		parse_fn parse{};
+		void const* grammar{};
+	};
+
+	template <typename Iterator, typename Context>
+	class rule : public parser<rule<Iterator, Context>> {
+		rule_definition<Iterator, Context> const* def_{};
+	public:
+		using iterator = Iterator;
+		using context_type = Context;
+		using definition = rule_definition<Iterator, Context>;
+
+		constexpr rule(definition const& def) noexcept : def_{ &def } {}
+
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			return def_->parse(def_->grammar, first, last, ctx);
+		}
+	};
+
+	namespace detail {
+		template <typename Parser, typename Iterator, typename Context>
+		bool parse_rule(void const* grammar, Iterator& first, const Iterator& last, Context& ctx) {
+			return static_cast<Parser const*>(grammar)->parse(first, last, ctx);
+		}
+	}
+
+	// The grammar must outlive the definition; in practice, it is a
+	// constexpr object at namespace scope of the defining translation unit.
+	template <typename Iterator, typename Context, typename Parser>
+	constexpr rule_definition<Iterator, Context> define(Parser const& grammar) noexcept {
+		using parser_t = as_parser_t<Parser>;
+		static_assert(std::is_same_v<parser_t, Parser>,
+			"rule needs a parser object, not a literal; wrap it with cell::as_parser");
+		return { &detail::parse_rule<parser_t, Iterator, Context>, &grammar };
+	}
+}
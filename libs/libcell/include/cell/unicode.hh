@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+
+#include "parser.hh"
+
+namespace cell {
+	namespace unicode {
+		constexpr char32_t invalid = ~char32_t{};
+
+		// UAX #31 character classes; ASCII is answered from the ascii table,
+		// the rest by a binary search over range tables in unicode.cc.
+		bool is_xid_start(char32_t) noexcept;
+		bool is_xid_continue(char32_t) noexcept;
+
+		// Returns the end of the longest run of [A-Za-z0-9_] starting at
+		// first. Uses SSE2/AVX2 (or NEON), if available, to look at 16 (or
+		// 32) bytes at a time.
+		char const* skip_ascii_word(char const* first,
+		                            char const* last) noexcept;
+
+		// Decodes one UTF-8 code point and moves first past it. Overlong
+		// forms, surrogates and truncated sequences are rejected with
+		// `invalid`, leaving first unchanged.
+		template <typename Iterator>
+		char32_t decode_utf8(Iterator& first, const Iterator& last) noexcept {
+			if (first == last) return invalid;
+
+			auto it = first;
+			auto const lead = static_cast<unsigned char>(*it);
+			++it;
+
+			if (lead < 0x80) {
+				first = it;
+				return lead;
+			}
+
+			std::size_t length{};
+			char32_t min{};
+			char32_t code{};
+			if ((lead & 0xE0) == 0xC0) {
+				length = 1;
+				min = 0x80;
+				code = lead & 0x1Fu;
+			} else if ((lead & 0xF0) == 0xE0) {
+				length = 2;
+				min = 0x800;
+				code = lead & 0x0Fu;
+			} else if ((lead & 0xF8) == 0xF0) {
+				length = 3;
+				min = 0x10000;
+				code = lead & 0x07u;
+			} else {
+				return invalid;
+			}
+
+			for (std::size_t index = 0; index < length; ++index) {
+				if (it == last) return invalid;
+				auto const trail = static_cast<unsigned char>(*it);
+				if ((trail & 0xC0) != 0x80) return invalid;
+				code = (code << 6) | (trail & 0x3Fu);
+				++it;
+			}
+
+			if (code < min || code > 0x10FFFF ||
+				(code >= 0xD800 && code <= 0xDFFF))
+				return invalid;
+
+			first = it;
+			return code;
+		}
+	}
+
+	template <typename Derived>
+	struct basic_is_a_code_point : character_parser<Derived> {
+		constexpr basic_is_a_code_point() = default;
+		/*overridable*/ bool is_a(char32_t) const noexcept { return false; }
+
+		template <typename Iterator, typename Context>
+		bool parse(Iterator& first, const Iterator& last, Context& ctx) const {
+			this->filter(first, last, ctx);
+			auto copy = first;
+			auto const code = unicode::decode_utf8(copy, last);
+			if (code == unicode::invalid || !this->derived().is_a(code))
+				return false;
+			first = copy;
+			return true;
+		}
+	};
+
+	struct is_a_xid_start : basic_is_a_code_point<is_a_xid_start> {
+		constexpr is_a_xid_start() = default;
+		bool is_a(char32_t c) const noexcept { return unicode::is_xid_start(c); }
+	};
+
+	struct is_a_xid_continue : basic_is_a_code_point<is_a_xid_continue> {
+		constexpr is_a_xid_continue() = default;
+		bool is_a(char32_t c) const noexcept { return unicode::is_xid_continue(c); }
+	};
+
+	constexpr auto xid_start = is_a_xid_start{};
+	constexpr auto xid_continue = is_a_xid_continue{};
+}
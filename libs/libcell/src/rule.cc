@@ -0,0 +1 @@
+#include "cell/rule.hh"
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+# Prints the XID_Start/XID_Continue range tables of src/unicode.cc, ready
+# to replace the ones between the "clang-format off/on" comments there.
+#
+# Python's str.isidentifier() follows UAX #31 (XID_Start or '_' for the
+# first character, XID_Continue for the rest), so the tables follow the
+# Unicode version of the interpreter running this script.
+#
+#     python3 tools/xid_tables.py
+
+import sys
+import unicodedata
+
+
+def ranges(pred):
+    result = []
+    start = None
+    for code in range(0x80, 0x110000):
+        if pred(code):
+            if start is None:
+                start = code
+        elif start is not None:
+            result.append((start, code - 1))
+            start = None
+    if start is not None:
+        result.append((start, 0x10FFFF))
+    return result
+
+
+def print_table(name, table):
+    print(f'\t\tconstexpr code_range {name}[] = {{')
+    line = '\t\t   '
+    for first, last in table:
+        item = f' {{0x{first:X}, 0x{last:X}}},'
+        if len(line.expandtabs(4)) + len(item) > 80:
+            print(line)
+            line = '\t\t   '
+        line += item
+    print(line)
+    print('\t\t};')
+
+
+print(f'\t\t// Unicode {unicodedata.unidata_version}, '
+      f'generated by tools/{__file__.split("/")[-1]}')
+print_table('xid_start', ranges(lambda code: chr(code).isidentifier()))
+print()
+print_table('xid_continue',
+            ranges(lambda code: ('a' + chr(code)).isidentifier()))
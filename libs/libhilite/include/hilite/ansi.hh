@@ -0,0 +1,26 @@
+#pragma once
+#include "hilite/renderer.hh"
+
+namespace hl::ansi {
+	// Returns SGR parameters (e.g. "1;34") for a token kind; empty result
+	// leaves the token in the color of the enclosing one.
+	using palette = std::string_view (*)(unsigned kind) noexcept;
+	std::string_view default_palette(unsigned kind) noexcept;
+
+	class renderer : public hl::renderer {
+	public:
+		renderer(std::string_view contents,
+		         output& out,
+		         palette colors = default_palette,
+		         std::size_t buffer_size = default_buffer_size);
+
+	protected:
+		void open(unsigned kind, const std::vector<token_stack_t>& stack) override;
+		void close(unsigned kind, const std::vector<token_stack_t>& stack) override;
+
+	private:
+		void select(std::string_view color);
+
+		palette palette_;
+	};
+}
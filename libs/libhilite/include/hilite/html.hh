@@ -0,0 +1,26 @@
+#pragma once
+#include "hilite/renderer.hh"
+
+namespace hl::html {
+	// Names the CSS class of a token kind, e.g. hl::cxx::token_to_string;
+	// the class attribute is "hl-" followed by the name.
+	using token_names = std::string_view (*)(unsigned kind) noexcept;
+
+	// Writes <span>s and escaped text only; the <pre> around it and the
+	// stylesheet are left to the caller.
+	class renderer : public hl::renderer {
+	public:
+		renderer(std::string_view contents,
+		         output& out,
+		         token_names names,
+		         std::size_t buffer_size = default_buffer_size);
+
+	protected:
+		void open(unsigned kind, const std::vector<token_stack_t>& stack) override;
+		void close(unsigned kind, const std::vector<token_stack_t>& stack) override;
+		void text(std::string_view chunk) override;
+
+	private:
+		token_names names_;
+	};
+}
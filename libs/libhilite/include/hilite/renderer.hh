@@ -0,0 +1,72 @@
+#pragma once
+#include "hilite/hilite.hh"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hl {
+	struct output {
+		output();
+		output(const output&) = delete;
+		output(output&&);
+		output& operator=(const output&) = delete;
+		output& operator=(output&&);
+
+		virtual ~output();
+		virtual void write(std::string_view chunk) = 0;
+	};
+
+	// Turns lines reported by a tokenizer into markup, as they arrive. The
+	// markup is collected in a buffer of fixed capacity and handed to the
+	// output in chunks of roughly that size; the only other state kept
+	// between the lines is the stack of tokens open in the current line.
+	//
+	// Call finish() after tokenize() returns, to write out the tail of the
+	// buffer. The destructor does not do it for you, as the output may
+	// throw; debug builds assert that nothing was left behind, unless an
+	// exception is already on its way out.
+	class renderer : public callback {
+	public:
+		static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+		renderer(std::string_view contents,
+		         output& out,
+		         std::size_t buffer_size = default_buffer_size);
+		~renderer() override;
+
+		void on_line(std::size_t start,
+		             std::size_t length,
+		             const tokens& highlights) final;
+		void finish();
+
+	protected:
+		virtual void begin_line() {}
+		virtual void end_line() {}
+		virtual void open(unsigned kind, const std::vector<token_stack_t>& stack) = 0;
+		virtual void close(unsigned kind, const std::vector<token_stack_t>& stack) = 0;
+		virtual void text(std::string_view chunk) { put(chunk); }
+
+		void put(std::string_view chunk) {
+			if (chunk.size() > buffer_.capacity() - buffer_.size())
+				overflow(chunk);
+			else
+				buffer_.append(chunk);
+		}
+
+		void put(char c) {
+			if (buffer_.size() == buffer_.capacity()) flush();
+			buffer_.push_back(c);
+		}
+
+	private:
+		void overflow(std::string_view chunk);
+		void flush();
+
+		std::string_view contents_;
+		output* out_;
+		std::string buffer_;
+		std::vector<token_stack_t> stack_;
+		bool first_line_{true};
+	};
+}
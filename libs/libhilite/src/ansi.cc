@@ -0,0 +1,71 @@
+#include "hilite/ansi.hh"
+
+namespace hl::ansi {
+	std::string_view default_palette(unsigned kind) noexcept {
+		using namespace std::literals;
+
+		switch (kind) {
+			case hl::line_comment:
+			case hl::block_comment:
+				return "32"sv;
+			case hl::keyword:
+				return "1;34"sv;
+			case hl::module_name:
+				return "1;36"sv;
+			case hl::known_ident_1:
+			case hl::known_ident_2:
+			case hl::known_ident_3:
+				return "36"sv;
+			case hl::number:
+				return "33"sv;
+			case hl::character:
+			case hl::char_encoding:
+			case hl::char_delim:
+			case hl::char_udl:
+			case hl::string:
+			case hl::string_encoding:
+			case hl::string_delim:
+			case hl::string_udl:
+			case hl::raw_string:
+				return "31"sv;
+			case hl::escape_sequence:
+				return "1;31"sv;
+			case hl::meta:
+				return "35"sv;
+			case hl::meta_identifier:
+				return "1;35"sv;
+			default:
+				break;
+		}
+
+		return {};
+	}
+
+	renderer::renderer(std::string_view contents,
+	                   output& out,
+	                   palette colors,
+	                   std::size_t buffer_size)
+	    : hl::renderer{contents, out, buffer_size}, palette_{colors} {}
+
+	void renderer::open(unsigned kind, const std::vector<token_stack_t>&) {
+		select(palette_(kind));
+	}
+
+	void renderer::close(unsigned kind,
+	                     const std::vector<token_stack_t>& stack) {
+		if (palette_(kind).empty()) return;
+
+		// SGR attributes cannot be popped one by one: reset and restore
+		// whatever the still open tokens had selected
+		put("\x1b[0m");
+		for (auto const& tok : stack)
+			select(palette_(tok.kind));
+	}
+
+	void renderer::select(std::string_view color) {
+		if (color.empty()) return;
+		put("\x1b[");
+		put(color);
+		put('m');
+	}
+}
@@ -0,0 +1,49 @@
+#include "hilite/html.hh"
+
+namespace hl::html {
+	renderer::renderer(std::string_view contents,
+	                   output& out,
+	                   token_names names,
+	                   std::size_t buffer_size)
+	    : hl::renderer{contents, out, buffer_size}, names_{names} {}
+
+	void renderer::open(unsigned kind, const std::vector<token_stack_t>&) {
+		auto const name = names_(kind);
+		if (name.empty()) {
+			put("<span>");
+			return;
+		}
+
+		put("<span class=\"hl-");
+		put(name);
+		put("\">");
+	}
+
+	void renderer::close(unsigned, const std::vector<token_stack_t>&) {
+		put("</span>");
+	}
+
+	void renderer::text(std::string_view chunk) {
+		auto pos = chunk.find_first_of("&<>\"");
+		while (pos != std::string_view::npos) {
+			put(chunk.substr(0, pos));
+			switch (chunk[pos]) {
+				case '&':
+					put("&amp;");
+					break;
+				case '<':
+					put("&lt;");
+					break;
+				case '>':
+					put("&gt;");
+					break;
+				default:
+					put("&quot;");
+					break;
+			}
+			chunk = chunk.substr(pos + 1);
+			pos = chunk.find_first_of("&<>\"");
+		}
+		put(chunk);
+	}
+}
@@ -0,0 +1,87 @@
+#include "hilite/renderer.hh"
+
+#include <assert.h>
+#include <algorithm>
+#include <exception>
+
+namespace hl {
+	output::~output() = default;
+	output::output() = default;
+	output::output(output&&) = default;
+	output& output::operator=(output&&) = default;
+
+	renderer::renderer(std::string_view contents,
+	                   output& out,
+	                   std::size_t buffer_size)
+	    : contents_{contents}, out_{&out} {
+		buffer_.reserve(std::max(buffer_size, std::size_t{1}));
+	}
+
+	renderer::~renderer() {
+		// finish() was not called and the tail of the markup is lost
+		assert(buffer_.empty() || std::uncaught_exceptions() > 0);
+	}
+
+	void renderer::on_line(std::size_t start,
+	                       std::size_t length,
+	                       const tokens& highlights) {
+		if (start > contents_.size()) return;
+		auto const line = contents_.substr(start, length);
+		length = line.size();
+
+		if (!first_line_) put('\n');
+		first_line_ = false;
+
+		begin_line();
+
+		std::size_t pos = 0;
+		auto const close_until = [&](std::size_t offset) {
+			while (!stack_.empty() && stack_.back().end <= offset) {
+				auto const top = stack_.back();
+				text(line.substr(pos, top.end - pos));
+				pos = top.end;
+				stack_.pop_back();
+				close(top.kind, stack_);
+			}
+		};
+
+		for (auto const& tok : highlights) {
+			if (tok.start >= length) break;
+			close_until(tok.start);
+			if (tok.start > pos) {
+				text(line.substr(pos, tok.start - pos));
+				pos = tok.start;
+			}
+
+			// tokens are sorted by start, then by longest; anything
+			// reaching past its parent is cut at the parent's end
+			auto end = std::min(tok.end, length);
+			if (!stack_.empty()) end = std::min(end, stack_.back().end);
+			if (end <= tok.start) continue;
+
+			stack_.push_back({end, tok.kind});
+			open(tok.kind, stack_);
+		}
+
+		close_until(length);
+		if (length > pos) text(line.substr(pos));
+
+		end_line();
+	}
+
+	void renderer::finish() { flush(); }
+
+	void renderer::overflow(std::string_view chunk) {
+		flush();
+		if (chunk.size() < buffer_.capacity())
+			buffer_.append(chunk);
+		else
+			out_->write(chunk);
+	}
+
+	void renderer::flush() {
+		if (buffer_.empty()) return;
+		out_->write(buffer_);
+		buffer_.clear();
+	}
+}
@@ -0,0 +1,217 @@
+#include "base/build_graph.hh"
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <queue>
+
+build_graph build_graph::from(std::vector<target> const& targets) {
+	build_graph graph{};
+	graph.producers.resize(targets.size());
+	graph.consumers.resize(targets.size());
+
+	std::map<artifact, size_t> produced_by{};
+	for (size_t id = 0; id < targets.size(); ++id) {
+		auto const& tgt = targets[id];
+		// directories are there before anything else runs
+		if (std::holds_alternative<std::monostate>(tgt.rule) ||
+		    tgt.rule == rule_name{rule_type::MKDIR})
+			continue;
+		produced_by[tgt.main_output] = id;
+		for (auto const* list : {&tgt.outputs.expl, &tgt.outputs.impl,
+		                         &tgt.outputs.order}) {
+			for (auto const& out : *list)
+				produced_by[out] = id;
+		}
+	}
+
+	for (size_t id = 0; id < targets.size(); ++id) {
+		auto const& tgt = targets[id];
+		auto& producers = graph.producers[id];
+		for (auto const* list :
+		     {&tgt.inputs.expl, &tgt.inputs.impl, &tgt.inputs.order}) {
+			for (auto const& in : *list) {
+				auto it = produced_by.find(in);
+				if (it == produced_by.end() || it->second == id) continue;
+				producers.push_back(it->second);
+			}
+		}
+		std::sort(producers.begin(), producers.end());
+		producers.erase(std::unique(producers.begin(), producers.end()),
+		                producers.end());
+		for (auto producer : producers)
+			graph.consumers[producer].push_back(id);
+	}
+
+	return graph;
+}
+
+std::vector<size_t> build_graph::topological_order() const {
+	std::vector<size_t> waiting(size());
+	std::vector<size_t> result{};
+	result.reserve(size());
+
+	for (size_t id = 0; id < size(); ++id) {
+		waiting[id] = producers[id].size();
+		if (!waiting[id]) result.push_back(id);
+	}
+
+	for (size_t index = 0; index < result.size(); ++index) {
+		for (auto consumer : consumers[result[index]]) {
+			if (!--waiting[consumer]) result.push_back(consumer);
+		}
+	}
+
+	return result;
+}
+
+critical_paths critical_paths::from(build_graph const& graph,
+                                    std::vector<double> cost) {
+	critical_paths result{};
+	cost.resize(graph.size());
+	result.cost = std::move(cost);
+	result.downstream = result.cost;
+	result.next.assign(graph.size(), build_graph::npos);
+
+	auto const order = graph.topological_order();
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		auto const id = *it;
+		for (auto consumer : graph.consumers[id]) {
+			auto const length = result.cost[id] + result.downstream[consumer];
+			if (length > result.downstream[id]) {
+				result.downstream[id] = length;
+				result.next[id] = consumer;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::vector<size_t> critical_paths::order() const {
+	std::vector<size_t> result(downstream.size());
+	std::iota(result.begin(), result.end(), size_t{});
+	std::stable_sort(result.begin(), result.end(),
+	                 [this](size_t lhs, size_t rhs) {
+		                 return downstream[lhs] > downstream[rhs];
+	                 });
+	return result;
+}
+
+std::vector<std::vector<size_t>> critical_paths::chains(
+    build_graph const& graph,
+    size_t count) const {
+	std::vector<std::vector<size_t>> result{};
+	for (auto id : order()) {
+		if (result.size() == count) break;
+		if (!graph.producers[id].empty() || !(downstream[id] > 0)) continue;
+
+		auto& chain = result.emplace_back();
+		for (auto node = id; node != build_graph::npos; node = next[node])
+			chain.push_back(node);
+	}
+	return result;
+}
+
+schedule schedule::simulate(build_graph const& graph,
+                            critical_paths const& paths,
+                            size_t workers) {
+	schedule result{};
+	result.workers = std::max(workers, size_t{1});
+	result.slots.resize(graph.size());
+
+	auto const by_priority = [&](size_t lhs, size_t rhs) {
+		if (paths.downstream[lhs] != paths.downstream[rhs])
+			return paths.downstream[lhs] < paths.downstream[rhs];
+		return lhs > rhs;
+	};
+	std::priority_queue<size_t, std::vector<size_t>, decltype(by_priority)>
+	    ready{by_priority};
+
+	using running_target = std::pair<double, size_t>;
+	std::priority_queue<running_target, std::vector<running_target>,
+	                    std::greater<running_target>>
+	    running{};
+
+	std::vector<size_t> waiting(graph.size());
+	for (size_t id = 0; id < graph.size(); ++id) {
+		waiting[id] = graph.producers[id].size();
+		if (!waiting[id]) ready.push(id);
+	}
+
+	std::vector<size_t> idle(result.workers);
+	std::iota(idle.rbegin(), idle.rend(), size_t{});
+	std::vector<size_t> last_on(result.workers, build_graph::npos);
+
+	double now{};
+	while (!ready.empty() || !running.empty()) {
+		while (!ready.empty() && !idle.empty()) {
+			auto const id = ready.top();
+			ready.pop();
+			auto const worker = idle.back();
+			idle.pop_back();
+
+			auto& slot = result.slots[id];
+			slot.start = now;
+			slot.finish = now + paths.cost[id];
+			slot.worker = worker;
+			slot.previous = last_on[worker];
+			last_on[worker] = id;
+			result.busy_time += paths.cost[id];
+			running.push({slot.finish, id});
+		}
+
+		auto const [finish, id] = running.top();
+		running.pop();
+		now = finish;
+		idle.push_back(result.slots[id].worker);
+		for (auto consumer : graph.consumers[id]) {
+			if (!--waiting[consumer]) ready.push(consumer);
+		}
+	}
+
+	result.wall_time = now;
+	return result;
+}
+
+std::vector<double> schedule::profile(size_t buckets) const {
+	std::vector<double> result(buckets);
+	if (!buckets || !(wall_time > 0)) return result;
+
+	auto const width = wall_time / static_cast<double>(buckets);
+	for (auto const& slot : slots) {
+		if (!(slot.finish > slot.start)) continue;
+		for (auto index = static_cast<size_t>(slot.start / width);
+		     index < buckets; ++index) {
+			auto const lo =
+			    std::max(slot.start, width * static_cast<double>(index));
+			auto const hi =
+			    std::min(slot.finish, width * static_cast<double>(index + 1));
+			if (!(hi > lo)) break;
+			result[index] += (hi - lo) / width;
+		}
+	}
+	return result;
+}
+
+std::vector<size_t> schedule::critical_chain(build_graph const& graph) const {
+	std::vector<size_t> result{};
+	auto node = build_graph::npos;
+	for (size_t id = 0; id < slots.size(); ++id) {
+		if (node == build_graph::npos || slots[id].finish > slots[node].finish)
+			node = id;
+	}
+
+	while (node != build_graph::npos) {
+		result.push_back(node);
+		auto next = slots[node].previous;
+		for (auto producer : graph.producers[node]) {
+			if (next == build_graph::npos ||
+			    slots[producer].finish > slots[next].finish)
+				next = producer;
+		}
+		node = next;
+	}
+
+	std::reverse(result.begin(), result.end());
+	return result;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <base/generator.hh>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Dependencies between generator targets: a target depends on every
+// target producing one of its inputs (explicit, implicit or order-only).
+// Directory targets are not treated as producers.
+struct build_graph {
+	static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+	std::vector<std::vector<size_t>> producers{};
+	std::vector<std::vector<size_t>> consumers{};
+
+	static build_graph from(std::vector<target> const& targets);
+
+	size_t size() const noexcept { return producers.size(); }
+	// producers before consumers; targets caught in a cycle are left out
+	std::vector<size_t> topological_order() const;
+};
+
+// Longest path from each target to the end of the build, with `cost`
+// being the time the target itself takes to build.
+struct critical_paths {
+	std::vector<double> cost{};
+	std::vector<double> downstream{};
+	std::vector<size_t> next{};
+
+	static critical_paths from(build_graph const& graph,
+	                           std::vector<double> cost);
+
+	// all targets, longest downstream path first; ties keep the original
+	// order
+	std::vector<size_t> order() const;
+	// up to `count` longest chains, each starting at a target with no
+	// producers
+	std::vector<std::vector<size_t>> chains(build_graph const& graph,
+	                                        size_t count) const;
+};
+
+// List scheduling of the graph on a number of workers: whenever a worker
+// is free, it takes the ready target with the longest downstream path.
+struct schedule {
+	struct slot {
+		double start{};
+		double finish{};
+		size_t worker{};
+		size_t previous{build_graph::npos};  // last target on that worker
+	};
+
+	size_t workers{};
+	double wall_time{};
+	double busy_time{};
+	std::vector<slot> slots{};
+
+	static schedule simulate(build_graph const& graph,
+	                         critical_paths const& paths,
+	                         size_t workers);
+
+	// busy workers, averaged over `buckets` equal slices of the wall time
+	std::vector<double> profile(size_t buckets) const;
+	// the targets which decided the wall time, from first to last: going
+	// back from the last to finish, each step takes the producer or the
+	// worker's previous target, whichever finished later
+	std::vector<size_t> critical_chain(build_graph const& graph) const;
+};
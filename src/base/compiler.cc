@@ -1,6 +1,5 @@
 #include "base/compiler.hh"
 #include <base/utils.hh>
-#include <deque>
 #include <env/defaults.hh>
 #include <env/path.hh>
 #include <fstream>
@@ -174,6 +173,8 @@ std::vector<templated_string> compiler::commands_for(rule_type) {
 	return {};
 }
 
+dep_format compiler::deps_for(rule_type) { return dep_format::none; }
+
 std::map<std::u8string, size_t> compiler::register_projects(
     build_info const& build,
     generator& gen) {
@@ -194,7 +195,6 @@ std::map<std::u8string, size_t> compiler::register_projects(
 }
 
 target compiler::create_project_target(
-    build_info const& build,
     project const& prj,
     project_info const& info,
     std::map<std::u8string, size_t> const& ids) {
@@ -226,31 +226,18 @@ target compiler::create_project_target(
 
 	auto const& mods = env::path_mods();
 
-	for (auto const& filename : info.sources) {
-		auto const objfile = mods.object.modify(filename).generic_u8string();
+	for (auto const& source : info.sources) {
+		auto const objfile =
+		    mods.object.modify(str(source.filename)).generic_u8string();
 
 		library.inputs.expl.push_back(file_ref{setup_id, objfile});
 	}
 
 	if (prj.type != project::static_lib) {
-		std::deque<project> stack{info.links.begin(), info.links.end()};
-		std::set<project> seen{prj};
-
-		while (!stack.empty()) {
-			auto next = stack.front();
-			stack.pop_front();
-
-			auto [_, first] = seen.insert(next);
-			if (!first) break;
-
+		for (auto const& next : info.link_line) {
 			auto const next_id = get_setup_id(next.name, ids);
 			library.inputs.expl.push_back(
 			    file_ref{next_id, next.filename(), file_ref::linked});
-
-			auto it = build.projects.find(next);
-			if (it == build.projects.end()) continue;
-			stack.insert(stack.end(), it->second.links.begin(),
-			             it->second.links.end());
 		}
 	}
 
@@ -275,7 +262,7 @@ void compiler::add_rules(rule_types const rules_needed, generator& gen) {
 
 	for (auto rule : rules) {
 		if (!rules_needed.has(rule)) continue;
-		results.push_back({rule, commands_for(rule)});
+		results.push_back({rule, commands_for(rule), {}, deps_for(rule)});
 	}
 	gen.set_rules(std::move(results));
 }
@@ -2,6 +2,7 @@
 
 #include <base/generator.hh>
 #include <fs/file.hh>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -12,12 +13,57 @@ struct compiler {
 	virtual ~compiler();
 	virtual void mapout(struct build_info const&, generator&);
 	virtual std::vector<templated_string> commands_for(rule_type);
+	virtual dep_format deps_for(rule_type);
+
+	// Up to `count` of the project headers weighing the most in the
+	// include graph are built as header units and imported in place of
+	// their #includes. Zero (the default) leaves the headers alone.
+	void promote_headers(size_t count) noexcept { promoted_headers_ = count; }
+
+	// Compilers able to write the interface while compiling the object
+	// can build an interface unit in one edge or, interface first, in two.
+	// With `automatic`, both target lists go to the generator, which keeps
+	// the one with the shorter critical path.
+	enum class bmi_phases { automatic, one, two };
+	void set_bmi_phases(bmi_phases phases) noexcept { bmi_phases_ = phases; }
+
+	// Non-module sources of a project are compiled in unity units of up
+	// to `sources` files or `bytes` of source text, whichever fills up
+	// first; zero leaves either one unbounded. With both at zero (the
+	// default), every source is compiled on its own.
+	void set_unity(size_t sources, std::uint64_t bytes) noexcept {
+		unity_sources_ = sources;
+		unity_bytes_ = bytes;
+	}
+
+	// c++modules itself, for the steps run by the build; without it, the
+	// options below needing one are off.
+	void set_tool(std::u8string tool) { tool_ = std::move(tool); }
+
+	// Implementation units of a module, from the same directory, are
+	// compiled in up to `units` translation units, merged from them by
+	// `c++modules merge-units` during the build. Zero (the default)
+	// compiles every unit on its own.
+	void merge_module_units(size_t units) noexcept { merged_units_ = units; }
+
+	// Small non-module sources of a project are compiled by a single
+	// compiler process for up to `bytes` of source text at a time, through
+	// `c++modules cc-batch`. Zero (the default) runs the compiler once for
+	// every source.
+	void batch_compiles(std::uint64_t bytes) noexcept { batch_bytes_ = bytes; }
 
 protected:
+	size_t promoted_headers_{0};
+	bmi_phases bmi_phases_{bmi_phases::automatic};
+	size_t unity_sources_{0};
+	std::uint64_t unity_bytes_{0};
+	size_t merged_units_{0};
+	std::uint64_t batch_bytes_{0};
+	std::u8string tool_{};
+
 	std::map<std::u8string, size_t> register_projects(struct build_info const&,
 	                                                  generator&);
-	target create_project_target(struct build_info const&,
-	                             struct project const&,
+	target create_project_target(struct project const&,
 	                             struct project_info const&,
 	                             std::map<std::u8string, size_t> const&);
 	void add_rules(rule_types bits, generator&);
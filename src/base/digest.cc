@@ -0,0 +1,34 @@
+#include "base/digest.hh"
+#include <openssl/evp.h>
+
+struct digest::context {
+	struct deleter {
+		void operator()(EVP_MD_CTX* ptr) { EVP_MD_CTX_free(ptr); }
+	};
+	std::unique_ptr<EVP_MD_CTX, deleter> md{EVP_MD_CTX_new()};
+};
+
+digest::digest() : ctx_{std::make_unique<context>()} {
+	EVP_DigestInit_ex(ctx_->md.get(), EVP_sha256(), nullptr);
+}
+
+digest::~digest() = default;
+
+void digest::update(std::string_view data) {
+	EVP_DigestUpdate(ctx_->md.get(), data.data(), data.size());
+}
+
+std::string digest::hex() {
+	unsigned char hash[EVP_MAX_MD_SIZE];
+	unsigned length{};
+	EVP_DigestFinal_ex(ctx_->md.get(), hash, &length);
+
+	static constexpr char alphabet[] = "0123456789abcdef";
+	std::string result{};
+	result.reserve(length * 2);
+	for (unsigned index = 0; index < length; ++index) {
+		result.push_back(alphabet[hash[index] >> 4]);
+		result.push_back(alphabet[hash[index] & 0xF]);
+	}
+	return result;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// SHA-256 over everything passed to update(), as lowercase hex.
+class digest {
+public:
+	digest();
+	~digest();
+	digest(digest const&) = delete;
+	digest& operator=(digest const&) = delete;
+
+	void update(std::string_view data);
+	void update(std::u8string_view data) {
+		update(std::string_view{reinterpret_cast<char const*>(data.data()),
+		                        data.size()});
+	}
+	std::string hex();
+
+private:
+	struct context;
+	std::unique_ptr<context> ctx_;
+};
@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 #include "types.hh"
@@ -15,7 +16,8 @@
 	X(LINK_LIBRARY) \
 	X(DEFINES)      \
 	X(CFLAGS)       \
-	X(CXXFLAGS)
+	X(CXXFLAGS)     \
+	X(DEPFILE)
 
 enum class var {
 #define ENUM(NAME) NAME,
@@ -33,6 +35,7 @@ using templated_string = std::vector<std::variant<std::string, named_var, var>>;
 	X(COMPILE)      \
 	X(EMIT_BMI)     \
 	X(EMIT_INCLUDE) \
+	X(COPY_BMI)     \
 	X(LINK_STATIC)  \
 	X(LINK_SO)      \
 	X(LINK_MOD)     \
@@ -61,16 +64,22 @@ struct rule_types {
 
 using rule_name = std::variant<std::monostate, std::string, rule_type>;
 
+// How the compiler reports the headers it has read: none, a Makefile
+// snippet (-MD -MF) or /showIncludes.
+enum class dep_format { none, gcc, msvc };
+
 struct rule {
 	rule_name name{};
 	std::vector<templated_string> commands{};
 	templated_string message{};
+	dep_format deps{dep_format::none};
 
 	static templated_string default_message(rule_type type);
 };
 
 struct file_ref {
-	enum kind { input, output, linked, header_module, include };
+	// external: outside of both source and binary dir, used as is
+	enum kind { input, output, linked, header_module, include, external };
 	size_t prj;
 	std::u8string path;
 	kind type{output};
@@ -98,6 +107,11 @@ struct target {
 	filelist inputs{};
 	filelist outputs{};
 	std::u8string edge{};
+	// edge-level variables, for commands naming them with <var name=.../>
+	std::vector<std::pair<std::string, std::u8string>> vars{};
+	// files the commands read, as (path from the binary dir, contents),
+	// e.g. a module map; written by the generator keeping the edge
+	std::vector<std::pair<std::filesystem::path, std::string>> files{};
 };
 
 struct project_setup {
@@ -113,6 +127,7 @@ struct generator {
 	virtual ~generator();
 	void set_rules(std::vector<rule> const& rules) { rules_ = rules; }
 	void set_rules(std::vector<rule>&& rules) { rules_ = std::move(rules); }
+	void add_rule(rule&& extra) { rules_.push_back(std::move(extra)); }
 
 	void set_setups(std::vector<project_setup> const& setups) {
 		setups_ = setups;
@@ -130,6 +145,13 @@ struct generator {
 	void set_targets(std::vector<target>&& targets) {
 		targets_ = std::move(targets);
 	}
+	// Another way to build the same outputs, e.g. with the interfaces and
+	// their objects built by the same edges; generators able to compare
+	// them may replace the targets with one of the variants, the rest
+	// ignore them.
+	void add_variant(std::vector<target>&& targets) {
+		variants_.push_back(std::move(targets));
+	}
 
 	template <typename Gen>
 	Gen copyTo() const& {
@@ -137,6 +159,8 @@ struct generator {
 		result.set_rules(rules_);
 		result.set_setups(setups_);
 		result.set_targets(targets_);
+		for (auto const& variant : variants_)
+			result.add_variant(std::vector<target>{variant});
 		return result;
 	}
 
@@ -146,6 +170,8 @@ struct generator {
 		result.set_rules(std::move(rules_));
 		result.set_setups(std::move(setups_));
 		result.set_targets(std::move(targets_));
+		for (auto& variant : variants_)
+			result.add_variant(std::move(variant));
 		return result;
 	}
 
@@ -156,4 +182,5 @@ protected:
 	std::vector<rule> rules_;
 	std::vector<project_setup> setups_;
 	std::vector<target> targets_;
+	std::vector<std::vector<target>> variants_;
 };
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "base/include_graph.hh"
+#include <fs/file.hh>
+#include <algorithm>
+#include <limits>
+
+using namespace std::literals;
+
+// File layout, all numbers as LEB128 (mtimes zigzagged first):
+//
+//   magic
+//   file count, then per file: path length, path bytes, mtime
+//   unit count, then per unit: inclusion count, then per inclusion:
+//       file index, depth, bytes
+namespace {
+	constexpr auto magic = "c++modules:includes:1\n"sv;
+	constexpr auto no_mtime = std::numeric_limits<std::int64_t>::min();
+
+	std::int64_t mtime_of(std::filesystem::path const& path) {
+		std::error_code ec{};
+		auto const mtime = std::filesystem::last_write_time(path, ec);
+		if (ec) return no_mtime;
+		return mtime.time_since_epoch().count();
+	}
+
+	struct writer {
+		std::string data{};
+
+		void number(std::uint64_t value) {
+			while (value >= 0x80) {
+				data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			data.push_back(static_cast<char>(value));
+		}
+
+		void signed_number(std::int64_t value) {
+			number((static_cast<std::uint64_t>(value) << 1) ^
+			       static_cast<std::uint64_t>(value >> 63));
+		}
+
+		void string(std::u8string_view value) {
+			number(value.size());
+			data.append(reinterpret_cast<char const*>(value.data()),
+			            value.size());
+		}
+	};
+
+	struct reader {
+		std::string_view data{};
+		bool failed{false};
+
+		std::uint64_t number() {
+			std::uint64_t result{};
+			for (unsigned shift = 0; shift < 64; shift += 7) {
+				if (data.empty()) break;
+				auto const byte = static_cast<unsigned char>(data.front());
+				data.remove_prefix(1);
+				result |= std::uint64_t{byte & 0x7Fu} << shift;
+				if (!(byte & 0x80)) return result;
+			}
+			failed = true;
+			return 0;
+		}
+
+		std::int64_t signed_number() {
+			auto const value = number();
+			return static_cast<std::int64_t>(value >> 1) ^
+			       -static_cast<std::int64_t>(value & 1);
+		}
+
+		std::u8string string() {
+			auto const length = number();
+			if (length > data.size()) {
+				failed = true;
+				return {};
+			}
+			std::u8string result{
+			    reinterpret_cast<char8_t const*>(data.data()), length};
+			data.remove_prefix(length);
+			return result;
+		}
+	};
+}  // namespace
+
+std::filesystem::path include_graph::location(
+    std::filesystem::path const& binary_dir) {
+	return binary_dir / u8"c++modules"sv / u8"includes.db"sv;
+}
+
+std::uint32_t include_graph::intern(std::u8string const& path) {
+	auto it = index_.find(path);
+	if (it != index_.end()) return it->second;
+
+	auto const id = static_cast<std::uint32_t>(files.size());
+	files.push_back({path, mtime_of(path)});
+	index_[path] = id;
+	return id;
+}
+
+void include_graph::add(std::span<include_entry const> tree) {
+	if (tree.empty()) return;
+	auto& unit = units.emplace_back();
+	unit.reserve(tree.size());
+	for (auto const& entry : tree)
+		unit.push_back({intern(entry.path), entry.depth, entry.bytes});
+}
+
+bool include_graph::store(std::filesystem::path const& db) const {
+	writer out{};
+	out.data.append(magic);
+	out.number(files.size());
+	for (auto const& file : files) {
+		out.string(file.path);
+		out.signed_number(file.mtime);
+	}
+	out.number(units.size());
+	for (auto const& unit : units) {
+		out.number(unit.size());
+		for (auto const& inc : unit) {
+			out.number(inc.file);
+			out.number(inc.depth);
+			out.number(inc.bytes);
+		}
+	}
+
+	auto file = fs::fopen(db, "wb");
+	return file && file.store(out.data.data(), out.data.size()) ==
+	                   out.data.size();
+}
+
+include_graph include_graph::load(std::filesystem::path const& db) {
+	auto const bytes = fs::fopen(db, "rb").read();
+	reader in{{bytes.data(), bytes.size()}};
+	if (!in.data.starts_with(magic)) return {};
+	in.data.remove_prefix(magic.size());
+
+	include_graph result{};
+	auto const file_count = in.number();
+	for (std::uint64_t id = 0; id < file_count && !in.failed; ++id) {
+		auto path = in.string();
+		auto const mtime = in.signed_number();
+		result.index_[path] = static_cast<std::uint32_t>(id);
+		result.files.push_back({std::move(path), mtime});
+	}
+
+	auto const unit_count = in.number();
+	for (std::uint64_t id = 0; id < unit_count && !in.failed; ++id) {
+		auto& unit = result.units.emplace_back();
+		auto const count = in.number();
+		for (std::uint64_t index = 0; index < count && !in.failed; ++index) {
+			auto const file = in.number();
+			auto const depth = in.number();
+			auto const size = in.number();
+			if (file >= result.files.size()) in.failed = true;
+			unit.push_back({static_cast<std::uint32_t>(file),
+			                static_cast<std::uint32_t>(depth), size});
+		}
+	}
+
+	if (in.failed) return {};
+	return result;
+}
+
+std::optional<std::uint32_t> include_graph::find(
+    std::u8string_view path) const {
+	auto it = index_.find(std::u8string{path});
+	if (it == index_.end()) return std::nullopt;
+	return it->second;
+}
+
+std::vector<include_graph::includer> include_graph::included_by(
+    std::uint32_t file) const {
+	std::vector<includer> result{};
+	for (std::uint32_t id = 0; id < units.size(); ++id) {
+		auto depth = std::numeric_limits<std::uint32_t>::max();
+		for (auto const& inc : units[id])
+			if (inc.file == file) depth = std::min(depth, inc.depth);
+		if (depth != std::numeric_limits<std::uint32_t>::max())
+			result.push_back({id, depth});
+	}
+	return result;
+}
+
+std::vector<include_graph::weight> include_graph::heaviest(
+    bool with_includes) const {
+	std::vector<weight> result(files.size());
+	constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+	std::vector<std::uint32_t> seen_in(files.size(), none);
+	std::vector<std::uint64_t> bytes{};
+	std::vector<size_t> open{};
+	for (std::uint32_t id = 0; id < units.size(); ++id) {
+		auto const& unit = units[id];
+
+		bytes.resize(unit.size());
+		for (size_t index = 0; index < unit.size(); ++index)
+			bytes[index] = unit[index].bytes;
+
+		if (with_includes) {
+			// the tree is in pre-order, so an inclusion is closed by the
+			// next one no deeper than itself
+			auto const close = [&] {
+				auto const index = open.back();
+				open.pop_back();
+				if (!open.empty()) bytes[open.back()] += bytes[index];
+			};
+			for (size_t index = 0; index < unit.size(); ++index) {
+				while (!open.empty() &&
+				       unit[open.back()].depth >= unit[index].depth)
+					close();
+				open.push_back(index);
+			}
+			while (!open.empty())
+				close();
+		}
+
+		for (size_t index = 0; index < unit.size(); ++index) {
+			auto const& inc = unit[index];
+			if (!inc.depth) continue;
+			auto& item = result[inc.file];
+			item.file = inc.file;
+			item.bytes += bytes[index];
+			if (seen_in[inc.file] != id) {
+				seen_in[inc.file] = id;
+				++item.units;
+			}
+		}
+	}
+
+	auto it = std::remove_if(result.begin(), result.end(),
+	                         [](weight const& item) { return !item.units; });
+	result.erase(it, result.end());
+	std::stable_sort(result.begin(), result.end(),
+	                 [](weight const& lhs, weight const& rhs) {
+		                 return lhs.bytes > rhs.bytes;
+	                 });
+	return result;
+}
+
+std::vector<std::uint32_t> include_graph::stale() const {
+	std::vector<bool> changed(files.size());
+	for (size_t id = 0; id < files.size(); ++id) {
+		auto const mtime = mtime_of(files[id].path);
+		changed[id] = mtime == no_mtime || mtime != files[id].mtime;
+	}
+
+	std::vector<std::uint32_t> result{};
+	for (std::uint32_t id = 0; id < units.size(); ++id) {
+		auto const& unit = units[id];
+		auto const is_changed = [&](inclusion const& inc) {
+			return changed[inc.file];
+		};
+		if (std::any_of(unit.begin(), unit.end(), is_changed))
+			result.push_back(id);
+	}
+	return result;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One inclusion read from the linemarkers of a preprocessed translation
+// unit. The unit itself comes first, at depth 0; `bytes` counts the
+// preprocessed output produced while this file was the current one, not
+// the files it included in turn.
+struct include_entry {
+	std::u8string path{};
+	std::uint32_t depth{};
+	std::uint64_t bytes{};
+};
+
+// Include trees of all scanned translation units, with the files shared
+// between the trees. Kept in the binary dir between runs, so the queries
+// do not need to preprocess anything.
+struct include_graph {
+	struct file {
+		std::u8string path{};
+		// last_write_time() seen when the tree was recorded
+		std::int64_t mtime{};
+	};
+
+	struct inclusion {
+		std::uint32_t file{};
+		std::uint32_t depth{};
+		std::uint64_t bytes{};
+	};
+
+	struct includer {
+		std::uint32_t unit{};
+		// depth of the shallowest inclusion
+		std::uint32_t depth{};
+	};
+
+	struct weight {
+		std::uint32_t file{};
+		std::uint64_t bytes{};
+		std::uint32_t units{};
+	};
+
+	std::vector<file> files{};
+	// each tree starts with the translation unit itself
+	std::vector<std::vector<inclusion>> units{};
+
+	// binary_dir/c++modules/includes.db
+	static std::filesystem::path location(
+	    std::filesystem::path const& binary_dir);
+
+	// paths are expected to be absolute and normalized
+	void add(std::span<include_entry const> tree);
+
+	bool store(std::filesystem::path const& db) const;
+	// missing or unreadable database gives an empty graph
+	static include_graph load(std::filesystem::path const& db);
+
+	std::optional<std::uint32_t> find(std::u8string_view path) const;
+	// units including the file, directly or not, in the unit order
+	std::vector<includer> included_by(std::uint32_t file) const;
+	// headers by the preprocessed bytes they add up to over all units;
+	// with_includes also counts the files each inclusion pulled in, which
+	// is what a header unit would save
+	std::vector<weight> heaviest(bool with_includes = false) const;
+	// units with a file changed (or gone) since the trees were recorded;
+	// their scan results cannot be reused
+	std::vector<std::uint32_t> stale() const;
+
+private:
+	std::uint32_t intern(std::u8string const& path);
+	std::unordered_map<std::u8string, std::uint32_t> index_{};
+};
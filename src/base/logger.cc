@@ -1,7 +1,29 @@
 #include "logger.hh"
 #include <base/utils.hh>
+#include <algorithm>
 #include <iostream>
 
+namespace {
+	std::u8string key_string(symbol key) { return str(key); }
+	std::u8string key_string(mod_name const& key) { return key.toString(); }
+
+	// hash maps in build_info have no order of their own; keep the log
+	// stable between runs
+	template <typename Map>
+	auto sorted(Map const& items) {
+		std::vector<std::pair<std::u8string, typename Map::mapped_type const*>>
+		    result{};
+		result.reserve(items.size());
+		for (auto const& [key, value] : items)
+			result.push_back({key_string(key), &value});
+		std::sort(result.begin(), result.end(),
+		          [](auto const& lhs, auto const& rhs) {
+			          return lhs.first < rhs.first;
+		          });
+		return result;
+	}
+}  // namespace
+
 void logger::print() {
 	if (!output) {
 		std::cerr << "c++modules: error: cannot open "
@@ -37,14 +59,14 @@ void logger::config() {
 	          "binary dir: "
 	       << as_sv(build.binary_dir) << '\n';
 	if (!build.imports.empty()) output << "requires\n";
-	for (auto const& [key, imports] : build.imports) {
+	for (auto const& [key, imports] : sorted(build.imports)) {
 		output << "    " << as_sv(key) << '\n';
-		for (auto const& mod : imports)
+		for (auto const& mod : *imports)
 			output << "        " << as_sv(mod.toString()) << '\n';
 	}
 	if (!build.exports.empty()) output << "provides\n";
-	for (auto const& [key, mod] : build.exports) {
-		output << "    " << as_sv(key) << " -> " << as_sv(mod.toString())
+	for (auto const& [key, mod] : sorted(build.exports)) {
+		output << "    " << as_sv(key) << " -> " << as_sv(mod->toString())
 		       << '\n';
 	}
 }
@@ -61,23 +83,26 @@ void logger::projects() {
 			output << "        " << as_sv(mod.toString()) << '\n';
 		if (!info.sources.empty()) output << "    includes\n";
 		for (auto const& source : info.sources)
-			output << "        " << as_sv(source) << '\n';
+			output << "        " << as_sv(str(source.filename)) << '\n';
 		if (!info.links.empty()) output << "    links to\n";
 		for (auto const& linked : info.links)
 			output << "        " << as_sv(linked.filename()) << '\n';
+		if (!info.link_line.empty()) output << "    link line\n";
+		for (auto const& linked : info.link_line)
+			output << "        " << as_sv(linked.filename()) << '\n';
 	}
 }
 
 void logger::source_refs() {
-	std::set<std::u8string> names;
+	std::map<std::u8string_view, symbol> names;
 
 	for (auto const& [path, _] : build.exports)
-		names.insert(path);
+		names[str(path)] = path;
 	for (auto const& [path, _] : build.imports)
-		names.insert(path);
+		names[str(path)] = path;
 
-	for (auto const& path : names) {
-		output << as_sv(path);
+	for (auto const& [name, path] : names) {
+		output << as_sv(name);
 
 		auto mod_it = build.exports.find(path);
 		if (mod_it != build.exports.end())
@@ -93,15 +118,16 @@ void logger::source_refs() {
 }
 
 void logger::modules() {
-	for (auto const& [modname, module] : build.modules) {
-		auto const mod = modname.toString();
+	for (auto const& [mod, info] : sorted(build.modules)) {
+		auto const& module = *info;
 		if (mod.empty())
 			output << "<global module>\n";
 		else
-			output << as_sv(mod) << " -> " << as_sv(module.interface) << '\n';
+			output << as_sv(mod) << " -> " << as_sv(str(module.interface))
+			       << '\n';
 		if (!module.sources.empty()) output << "    sources\n";
 		for (auto const& source : module.sources)
-			output << "        " << as_sv(source) << '\n';
+			output << "        " << as_sv(str(source)) << '\n';
 		if (!module.req.empty()) output << "    requires\n";
 		for (auto const& name : module.req)
 			output << "        " << as_sv(name.toString()) << '\n';
@@ -0,0 +1,28 @@
+#include "base/symbols.hh"
+
+symbol_table::symbol_table() {
+	strings_.emplace_back();
+	ids_[strings_.back()] = symbol::empty;
+}
+
+symbol symbol_table::intern(std::u8string_view value) {
+	auto it = ids_.find(value);
+	if (it != ids_.end()) return it->second;
+
+	auto const id = static_cast<symbol>(strings_.size());
+	strings_.emplace_back(value);
+	ids_.emplace(strings_.back(), id);
+	return id;
+}
+
+std::optional<symbol> symbol_table::find(
+    std::u8string_view value) const noexcept {
+	auto it = ids_.find(value);
+	if (it == ids_.end()) return std::nullopt;
+	return it->second;
+}
+
+symbol_table& symbols() {
+	static symbol_table table{};
+	return table;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Dense id of an interned string. Module names, partitions and source
+// paths are interned once and compared, hashed and stored as ids; the
+// strings are looked up only when logging and generating.
+enum class symbol : std::uint32_t { empty = 0 };
+
+class symbol_table {
+public:
+	symbol_table();
+	symbol_table(const symbol_table&) = delete;
+	symbol_table& operator=(const symbol_table&) = delete;
+
+	symbol intern(std::u8string_view value);
+	std::optional<symbol> find(std::u8string_view value) const noexcept;
+	std::u8string const& operator[](symbol id) const noexcept {
+		return strings_[static_cast<std::size_t>(id)];
+	}
+	std::size_t size() const noexcept { return strings_.size(); }
+
+private:
+	// deque keeps the strings in place, so the keys can view them
+	std::deque<std::u8string> strings_{};
+	std::unordered_map<std::u8string_view, symbol> ids_{};
+};
+
+// The table used by the whole run; not synchronized, since the sources
+// are scanned on a single thread.
+symbol_table& symbols();
+
+inline symbol intern(std::u8string_view value) {
+	return symbols().intern(value);
+}
+
+inline std::u8string const& str(symbol id) noexcept {
+	return symbols()[id];
+}
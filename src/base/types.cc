@@ -76,12 +76,114 @@ namespace {
 
 			if (sources.empty()) continue;
 
+			std::vector<std::filesystem::path> no_unity;
+			if (auto json_no_unity = cast_from_json<json::array>(
+			        json_project, u8"no-unity"sv)) {
+				for (auto& json_item : *json_no_unity) {
+					auto item = cast<json::string>(json_item);
+					if (item) no_unity.emplace_back(*item);
+				}
+			}
+
 			result[std::move(pro)] = project::setup{
 			    subdir.generic_u8string(),
 			    std::move(sources),
+			    std::move(no_unity),
 			};
 		}
 	}
+
+	class link_graph {
+	public:
+		explicit link_graph(std::map<project, project_info>& projects) {
+			nodes_.reserve(projects.size());
+			for (auto& [prj, info] : projects)
+				nodes_.push_back({&prj, &info});
+
+			// a library and an executable may share a name
+			std::map<project, size_t> index{};
+			for (size_t id = 0; id < nodes_.size(); ++id)
+				index[*nodes_[id].prj] = id;
+
+			for (auto& node : nodes_) {
+				for (auto const& linked : node.info->links) {
+					auto it = index.find(linked);
+					if (it != index.end()) node.links.push_back(it->second);
+				}
+			}
+
+			words_ = (nodes_.size() + 63) / 64;
+			closures_.resize(nodes_.size() * words_);
+		}
+
+		void compute() {
+			// post-order visits dependencies before their dependents, so
+			// every closure is complete by the time it is merged upwards
+			std::vector<state> states(nodes_.size(), state::unseen);
+			order_.reserve(nodes_.size());
+			for (size_t id = 0; id < nodes_.size(); ++id)
+				visit(id, states);
+
+			// reversed, it puts every project before what it links to
+			for (auto node_id : order_) {
+				auto& line = nodes_[node_id].info->link_line;
+				line.clear();
+				for (auto it = order_.rbegin(); it != order_.rend(); ++it) {
+					if (has(node_id, *it)) line.push_back(*nodes_[*it].prj);
+				}
+			}
+		}
+
+	private:
+		enum class state { unseen, open, done };
+
+		struct node {
+			project const* prj;
+			project_info* info;
+			std::vector<size_t> links{};
+		};
+
+		void visit(size_t id, std::vector<state>& states) {
+			if (states[id] != state::unseen) return;
+			states[id] = state::open;
+
+			for (auto linked : nodes_[id].links) {
+				if (states[linked] == state::open) {
+					std::cerr << "c++modules: warning: link cycle between "
+					          << as_sv(nodes_[id].prj->name) << " and "
+					          << as_sv(nodes_[linked].prj->name) << '\n';
+					continue;
+				}
+				visit(linked, states);
+				set(id, linked);
+				merge(id, linked);
+			}
+
+			states[id] = state::done;
+			order_.push_back(id);
+		}
+
+		std::uint64_t* closure(size_t id) {
+			return closures_.data() + id * words_;
+		}
+		bool has(size_t id, size_t bit) const {
+			return (closures_[id * words_ + bit / 64] >> (bit % 64)) & 1u;
+		}
+		void set(size_t id, size_t bit) {
+			closure(id)[bit / 64] |= std::uint64_t{1} << (bit % 64);
+		}
+		void merge(size_t id, size_t from) {
+			auto dst = closure(id);
+			auto src = closure(from);
+			for (size_t word = 0; word < words_; ++word)
+				dst[word] |= src[word];
+		}
+
+		std::vector<node> nodes_{};
+		std::vector<size_t> order_{};
+		size_t words_{};
+		std::vector<std::uint64_t> closures_{};
+	};
 }  // namespace
 
 std::u8string project::filename() const {
@@ -100,43 +202,47 @@ std::map<project, project::setup> project::load(fs::path const& source_dir) {
 }
 
 std::u8string mod_name::toString() const {
+	auto const& module_str = str(module);
+	auto const& part_str = str(part);
 	std::u8string result{};
-	auto size = module.size() + part.size();
-	if (!part.empty()) ++size;
+	auto size = module_str.size() + part_str.size();
+	if (!part_str.empty()) ++size;
 	result.reserve(size);
-	result.append(module);
-	if (!part.empty()) {
+	result.append(module_str);
+	if (!part_str.empty()) {
 		result.push_back(':');
-		result.append(part);
+		result.append(part_str);
 	}
 	return result;
 }
 
 std::u8string mod_name::toBMI() const {
+	auto const& module_str = str(module);
+	auto const& part_str = str(part);
 	std::u8string result{};
-	auto size = module.size() + part.size() + 4;
-	if (!part.empty()) ++size;
+	auto size = module_str.size() + part_str.size() + 4;
+	if (!part_str.empty()) ++size;
 	result.reserve(size);
-	result.append(module);
-	if (!part.empty()) {
+	result.append(module_str);
+	if (!part_str.empty()) {
 		result.push_back('-');
-		result.append(part);
+		result.append(part_str);
 	}
 	result.append(u8".bmi"sv);
 	return result;
 }
 
+static fs::path normalized(fs::path const& path) {
+	std::error_code ec;
+	auto abs = fs::absolute(path, ec);
+	if (!ec) return abs.lexically_normal();
+	auto canonical = fs::weakly_canonical(path, ec);
+	if (!ec) return canonical.lexically_normal();
+	return path.lexically_normal();
+}
+
 static build_info normalized_paths(std::filesystem::path const& source_dir,
                                    std::filesystem::path const& binary_dir) {
-	auto normalized = [](fs::path const& path) -> fs::path {
-		std::error_code ec;
-		auto abs = fs::absolute(path, ec);
-		if (!ec) return abs.lexically_normal();
-		auto canonical = fs::weakly_canonical(path, ec);
-		if (!ec) return canonical.lexically_normal();
-		return path.lexically_normal();
-	};
-
 	return {normalized(source_dir).generic_u8string(),
 	        normalized(binary_dir).generic_u8string()};
 }
@@ -147,87 +253,128 @@ build_info build_info::analyze(
     std::filesystem::path const& source_dir,
     std::filesystem::path const& binary_dir) {
 	auto build = normalized_paths(source_dir, binary_dir);
+	auto const back_to_sources = build.source_from_binary();
 
 	for (auto const& [project, setup] : projects) {
 		auto& dependency = build.projects[project];
 		dependency.subdir = setup.subdir;
 		dependency.sources.reserve(setup.sources.size());
-		std::transform(setup.sources.begin(), setup.sources.end(),
-		               std::back_inserter(dependency.sources),
-		               [](fs::path const& p) { return p.generic_u8string(); });
 
 		for (auto const& source : setup.sources) {
+			auto const path = intern(
+			    (setup.subdir / source).lexically_normal().generic_u8string());
+			auto const unity =
+			    std::find(setup.no_unity.begin(), setup.no_unity.end(),
+			              source) == setup.no_unity.end();
+			dependency.sources.push_back(
+			    {intern(source.generic_u8string()), path, unity});
+
 			auto srcfile =
 			    (source_dir / setup.subdir / source).lexically_normal();
 			auto const text = cxx.preproc(srcfile);
 			if (!text) continue;
 
 			auto unit = cxx::scan(*text);
+			// the compiler was started in the current directory, with the
+			// full path of the source; the build gives it the path from
+			// the binary dir instead
+			auto const full_dir =
+			    srcfile.parent_path().generic_u8string() + u8'/';
+			auto const from_binary =
+			    (back_to_sources / setup.subdir / source)
+			        .parent_path()
+			        .generic_u8string() +
+			    u8'/';
+			std::map<std::u8string, std::u8string> names{};
+			for (auto& entry : unit.includes) {
+				auto spelled = std::move(entry.path);
+				entry.path = normalized(spelled).generic_u8string();
+				if (!spelled.starts_with(full_dir)) continue;
+				auto name = from_binary + spelled.substr(full_dir.size());
+				if (name != entry.path) names[entry.path] = std::move(name);
+			}
+			if (!names.empty() && !unit.includes.empty())
+				build.include_names[unit.includes.front().path] =
+				    std::move(names);
+			build.includes.add(unit.includes);
 
-			auto u8path =
-			    (setup.subdir / source).lexically_normal().generic_u8string();
+			auto& mod = build.modules[unit.name];
 
 			if (!unit.name.empty()) {
 				if (unit.is_interface) {
-					build.modules[unit.name].interface = u8path;
-					build.exports[u8path] = unit.name;
-					dependency.exports.insert(unit.name);
+					mod.interface = path;
+					build.exports[path] = unit.name;
+					dependency.exports.push_back(unit.name);
 				}
 			}
-			build.modules[unit.name].libs.insert(project);
-			if (!unit.is_interface)
-				build.modules[unit.name].sources.push_back(u8path);
-
-			for (auto& import : unit.imports) {
-				if (unit.name != import)
-					build.modules[unit.name].req.insert(import);
-				dependency.imports.insert(import);
-				build.imports[u8path].push_back(import);
+			mod.libs.insert(project);
+			if (!unit.is_interface) mod.sources.push_back(path);
+
+			if (!unit.imports.empty()) {
+				auto& imports = build.imports[path];
+				for (auto& import : unit.imports) {
+					if (unit.name != import) mod.req.push_back(import);
+					dependency.imports.push_back(import);
+					imports.push_back(import);
+				}
 			}
 		}
 
-		std::vector<mod_name> imports{dependency.imports.begin(),
-		                              dependency.imports.end()};
+		sort_unique(dependency.exports);
+		sort_unique(dependency.imports);
+
 		auto it = std::remove_if(
-		    imports.begin(), imports.end(), [&](mod_name const& mod) {
-			    bool found = false;
-			    for (auto const& rhs : dependency.exports) {
-				    if (rhs == mod) {
-					    found = true;
-					    break;
-				    }
-			    }
-			    return found;
+		    dependency.imports.begin(), dependency.imports.end(),
+		    [&](mod_name const& mod) {
+			    return std::binary_search(dependency.exports.begin(),
+			                              dependency.exports.end(), mod);
 		    });
+		dependency.imports.erase(it, dependency.imports.end());
+	}
+
+	for (auto& [_, mod] : build.modules)
+		sort_unique(mod.req);
+
+	// index of projects providing each module; every provider gets linked,
+	// but more than one of them usually means a mistake in sources.json
+	std::unordered_map<mod_name, std::vector<project const*>> providers{};
+	std::vector<mod_name> ambiguous{};
+	for (auto const& [prj, deps] : build.projects) {
+		for (auto const& mod : deps.exports) {
+			auto& list = providers[mod];
+			list.push_back(&prj);
+			if (list.size() == 2) ambiguous.push_back(mod);
+		}
+	}
 
-		dependency.imports = std::set<mod_name>{imports.begin(), it};
+	for (auto const& mod : ambiguous) {
+		std::cerr << "c++modules: warning: module "
+		          << as_sv(mod.toString()) << " is provided by";
+		auto sep = " "sv;
+		for (auto const* prj : providers[mod]) {
+			std::cerr << sep << as_sv(prj->name);
+			sep = ", "sv;
+		}
+		std::cerr << '\n';
 	}
 
 	// turn project level imports into link dependencies
 	for (auto& [prj, deps] : build.projects) {
-		std::vector<mod_name> imports{deps.imports.begin(), deps.imports.end()};
-
 		auto it = std::remove_if(
-		    imports.begin(), imports.end(),
-		    [&ref = deps, &build](mod_name const& mod) {
-			    bool found = false;
-			    for (auto const& [rhs_prj, rhs_deps] : build.projects) {
-				    for (auto const& rhs : rhs_deps.exports) {
-					    if (rhs == mod) {
-						    // ok, this library provides a part of module, note
-						    // that down and carry on
-						    found = true;
-						    ref.links.insert(rhs_prj);
-						    break;
-					    }
-				    }
-			    }
-			    return found;
+		    deps.imports.begin(), deps.imports.end(),
+		    [&ref = deps, &providers](mod_name const& mod) {
+			    auto found = providers.find(mod);
+			    if (found == providers.end()) return false;
+			    for (auto const* provider : found->second)
+				    ref.links.insert(*provider);
+			    return true;
 		    });
 
-		deps.imports = std::set<mod_name>{imports.begin(), it};
+		deps.imports.erase(it, deps.imports.end());
 	}
 
+	link_graph{build.projects}.compute();
+
 	return build;
 }
 
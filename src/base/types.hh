@@ -1,9 +1,13 @@
 #pragma once
 
+#include <base/include_graph.hh>
+#include <base/symbols.hh>
+#include <algorithm>
 #include <filesystem>
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace std::literals;
@@ -23,6 +27,8 @@ struct project {
 	struct setup {
 		std::filesystem::path subdir;
 		std::vector<std::filesystem::path> sources;
+		// sources listed in "no-unity", never put in a unity unit
+		std::vector<std::filesystem::path> no_unity{};
 	};
 
 	static std::map<project, setup> load(
@@ -30,43 +36,86 @@ struct project {
 };
 
 struct mod_name {
-	std::u8string module;
-	std::u8string part;
-
-	bool empty() const noexcept { return module.empty() && part.empty(); }
+	symbol module{};
+	symbol part{};
+
+	mod_name() = default;
+	mod_name(symbol module, symbol part = symbol::empty)
+	    : module{module}, part{part} {}
+	mod_name(std::u8string_view module, std::u8string_view part = {})
+	    : module{intern(module)}, part{intern(part)} {}
+
+	bool empty() const noexcept {
+		return module == symbol::empty && part == symbol::empty;
+	}
 	std::u8string toString() const;
 	std::u8string toBMI() const;
 	auto operator<=>(mod_name const&) const = default;
 };
 
+template <>
+struct std::hash<mod_name> {
+	std::size_t operator()(mod_name const& name) const noexcept {
+		auto const module = static_cast<std::uint64_t>(name.module);
+		auto const part = static_cast<std::uint64_t>(name.part);
+		return std::hash<std::uint64_t>{}(module << 32 | part);
+	}
+};
+
+// Sorts and removes duplicates; used on vectors standing in for sets of
+// ids, once they are filled.
+template <typename Vector>
+void sort_unique(Vector& items) {
+	std::sort(items.begin(), items.end());
+	items.erase(std::unique(items.begin(), items.end()), items.end());
+}
+
 struct module_unit {
 	mod_name name{};
 	std::vector<mod_name> imports{};
 	bool is_interface{false};
+	std::vector<include_entry> includes{};
 };
 
 struct module_info {
-	std::u8string interface;
-	std::vector<std::u8string> sources;
-	std::set<mod_name> req;
+	symbol interface{};
+	std::vector<symbol> sources;
+	std::vector<mod_name> req;
 	std::set<project> libs;
 };
 
 struct project_info {
+	struct source {
+		symbol filename{};  // as listed in sources.json
+		symbol path{};      // relative to source_dir, normalized
+		bool unity{true};   // false, if listed in "no-unity"
+	};
+
 	std::filesystem::path subdir;
-	std::vector<std::u8string> sources;
-	std::set<mod_name> exports;
-	std::set<mod_name> imports;
+	std::vector<source> sources;
+	std::vector<mod_name> exports;
+	std::vector<mod_name> imports;
 	std::set<project> links;
+	// transitive closure of links, each project before the ones it links
+	// to, ready for single-pass linkers
+	std::vector<project> link_line;
 };
 
 struct build_info {
 	std::u8string source_dir{};
 	std::u8string binary_dir{};
-	std::map<mod_name, module_info> modules{};
+	std::unordered_map<mod_name, module_info> modules{};
 	std::map<project, project_info> projects{};
-	std::map<std::u8string, std::vector<mod_name>> imports{};
-	std::map<std::u8string, mod_name> exports{};
+	std::unordered_map<symbol, std::vector<mod_name>> imports{};
+	std::unordered_map<symbol, mod_name> exports{};
+	include_graph includes{};
+	// Headers found next to the file including them are named by the
+	// compiler after the path of that file; run from the binary dir, it
+	// calls them "../dir/../header.h" instead of "/src/header.h". Kept
+	// for each translation unit (by its normalized path), for the headers
+	// it names differently than the include graph.
+	std::map<std::u8string, std::map<std::u8string, std::u8string>>
+	    include_names{};
 
 	static build_info analyze(std::map<project, project::setup> const&,
 	                          struct compiler_info const&,
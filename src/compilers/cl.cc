@@ -2,7 +2,6 @@
 #include <env/binary_interface.hh>
 #include <env/path.hh>
 #include <env/defaults.hh>
-#include <deque>
 
 using namespace std::literals;
 
@@ -31,13 +30,14 @@ void cl::mapout(build_info const& build, generator& gen) {
 	for (auto const& [prj, info] : build.projects) {
 		auto const setup_id = get_setup_id(prj.name, ids);
 
-		for (auto const& filename : info.sources) {
+		for (auto const& source : info.sources) {
+			auto const& filename = str(source.filename);
 			auto const srcfile = (info.subdir / filename).generic_u8string();
 			auto const objfile =
 			    mods.object.modify(filename).generic_u8string();
 
-			auto const mods_it = build.imports.find(srcfile);
-			auto const iface_it = build.exports.find(srcfile);
+			auto const mods_it = build.imports.find(source.path);
+			auto const iface_it = build.exports.find(source.path);
 
 			auto const has_modules = mods_it != build.imports.end();
 			auto const is_interface = iface_it != build.exports.end();
@@ -97,7 +97,7 @@ void cl::mapout(build_info const& build, generator& gen) {
 		}
 
 		{
-			auto library = create_project_target(build, prj, info, ids);
+			auto library = create_project_target(prj, info, ids);
 			if (std::holds_alternative<rule_type>(library.rule)) {
 				rules_needed.set(std::get<rule_type>(library.rule));
 			}
@@ -128,30 +128,16 @@ void cl::mapout(build_info const& build, generator& gen) {
 					break;
 			}
 
-			for (auto const& filename : info.sources) {
+			for (auto const& source : info.sources) {
 				library.inputs.expl.push_back(
-				    file_ref{setup_id, filename, file_ref::input});
+				    file_ref{setup_id, str(source.filename), file_ref::input});
 			}
 
 			if (prj.type != project::static_lib) {
-				std::deque<project> stack{info.links.begin(), info.links.end()};
-				std::set<project> seen{prj};
-
-				while (!stack.empty()) {
-					auto next = stack.front();
-					stack.pop_front();
-
-					auto [_, first] = seen.insert(next);
-					if (!first) break;
-
+				for (auto const& next : info.link_line) {
 					auto const next_id = get_setup_id(next.name, ids);
 					library.inputs.impl.push_back(
 					    file_ref{next_id, next.name, file_ref::linked});
-
-					auto it = build.projects.find(next);
-					if (it == build.projects.end()) continue;
-					stack.insert(stack.end(), it->second.links.begin(),
-					             it->second.links.end());
 				}
 			}
 			targets.push_back(std::move(library));
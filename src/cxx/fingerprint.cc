@@ -0,0 +1,148 @@
+#include "cxx/fingerprint.hh"
+#include <base/digest.hh>
+#include <hilite/cxx.hh>
+
+using namespace std::literals;
+
+namespace cxx {
+	namespace {
+		bool is_space(char c) noexcept {
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+			       c == '\v' || c == '\f';
+		}
+
+		bool is_literal(unsigned kind) noexcept {
+			switch (static_cast<hl::cxx::token>(kind)) {
+				case hl::cxx::string:
+				case hl::cxx::raw_string:
+				case hl::cxx::character:
+					return true;
+				default:
+					break;
+			}
+			return false;
+		}
+
+		// Leaf tokens go to the digest one by one, with a separator in
+		// between; literals are kept verbatim. Text the tokenizer leaves
+		// alone is taken character by character, with comments and runs of
+		// whitespace turned into a separator.
+		struct callback : hl::callback {
+			std::string_view text{};
+			digest hash{};
+			std::string buffer{};
+			bool separate{false};
+			bool directive{false};
+			bool block_comment{false};
+			bool started{false};  // anything since the last line break
+
+			explicit callback(std::string_view text) : text{text} {}
+
+			void on_line(std::size_t start,
+			             std::size_t length,
+			             hl::tokens const& highlights) override {
+				auto const line = text.substr(start, length);
+				bool continued = false;
+				bool significant = false;
+				size_t pos = 0;
+
+				auto const plain = [&](size_t until) {
+					while (pos < until) {
+						auto const rest = line.substr(pos, until - pos);
+						if (block_comment) {
+							auto const stop = rest.find("*/"sv);
+							if (stop == std::string_view::npos) {
+								pos = until;
+								break;
+							}
+							pos += stop + 2;
+							block_comment = false;
+							separate = true;
+							continue;
+						}
+						if (rest.starts_with("//"sv)) {
+							pos = until;
+							separate = true;
+							break;
+						}
+						if (rest.starts_with("/*"sv)) {
+							pos += 2;
+							block_comment = true;
+							continue;
+						}
+
+						auto const c = line[pos++];
+						if (is_space(c)) {
+							separate = true;
+							continue;
+						}
+						if (!significant && c == '#') directive = true;
+						significant = true;
+						put(std::string_view{&c, 1});
+					}
+				};
+
+				for (size_t index = 0; index < highlights.size(); ++index) {
+					auto const& tok = highlights[index];
+					if (tok.start < pos) continue;  // inside a leaf or literal
+					plain(tok.start);
+					if (block_comment) continue;
+
+					auto const end = std::min(tok.end, line.size());
+					auto const kind = static_cast<hl::cxx::token>(tok.kind);
+					if (kind == hl::cxx::deleted_newline) {
+						continued = true;
+						pos = end;
+						continue;
+					}
+
+					auto const has_children =
+					    index + 1 < highlights.size() &&
+					    highlights[index + 1].start < tok.end;
+					if (has_children && !is_literal(tok.kind)) continue;
+
+					significant = true;
+					put(line.substr(tok.start, end - tok.start));
+					separate = !is_literal(tok.kind);
+					pos = end;
+
+					// a raw string going on in the next line
+					if (kind == hl::cxx::raw_string && end == line.size() &&
+					    !line.ends_with('"'))
+						buffer.push_back('\n');
+				}
+				plain(line.size());
+
+				if (directive && !continued && !block_comment) {
+					buffer.push_back('\n');
+					separate = false;
+					started = false;
+					directive = false;
+				} else {
+					separate = true;
+				}
+
+				if (buffer.size() > 16384) flush();
+			}
+
+			void put(std::string_view chunk) {
+				if (separate && started) buffer.push_back(' ');
+				separate = false;
+				started = true;
+				buffer.append(chunk);
+			}
+
+			void flush() {
+				hash.update(buffer);
+				buffer.clear();
+			}
+		};
+	}  // namespace
+
+	std::string fingerprint(std::string_view text) {
+		callback cb{text};
+		hl::cxx::tokenize(text, cb);
+		cb.flush();
+		return cb.hash.hex();
+	}
+}  // namespace cxx
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace cxx {
+	// Digest of the token stream of a source: comments and whitespace
+	// count as a single separator and line breaks only end preprocessor
+	// directives, so reformatting and comment edits leave it alone.
+	std::string fingerprint(std::string_view text);
+}  // namespace cxx
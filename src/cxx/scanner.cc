@@ -2,6 +2,8 @@
 #include <base/utils.hh>
 #include <hilite/cxx.hh>
 #include <algorithm>
+#include <cctype>
+#include <optional>
 
 using namespace std::literals;
 
@@ -53,6 +55,110 @@ namespace {
 		return out;
 	}
 
+	struct linemarker {
+		std::u8string path{};
+		bool enter{false};
+		bool leave{false};
+	};
+
+	// GCC and Clang write `# <line> "<file>" <flags>...`, with flag 1 for
+	// entering an include and 2 for returning from one; MSVC writes
+	// `#line <line> "<file>"` and leaves the direction to be guessed.
+	std::optional<linemarker> read_linemarker(std::string_view line) {
+		if (!line.starts_with('#')) return std::nullopt;
+		line.remove_prefix(1);
+		if (line.starts_with("line"sv)) line.remove_prefix(4);
+
+		auto const skip_spaces = [&] {
+			while (!line.empty() &&
+			       (line.front() == ' ' || line.front() == '\t'))
+				line.remove_prefix(1);
+		};
+		auto const at_digit = [&] {
+			return !line.empty() &&
+			       std::isdigit(static_cast<unsigned char>(line.front()));
+		};
+
+		skip_spaces();
+		if (!at_digit()) return std::nullopt;
+		while (at_digit())
+			line.remove_prefix(1);
+		skip_spaces();
+		if (!line.starts_with('"')) return std::nullopt;
+		line.remove_prefix(1);
+
+		linemarker result{};
+		while (!line.empty() && line.front() != '"') {
+			if (line.front() == '\\' && line.size() > 1) line.remove_prefix(1);
+			result.path.push_back(static_cast<char8_t>(line.front()));
+			line.remove_prefix(1);
+		}
+		if (line.empty()) return std::nullopt;
+		line.remove_prefix(1);
+
+		while (true) {
+			skip_spaces();
+			if (line.empty()) break;
+			auto const flag = line.front();
+			line.remove_prefix(1);
+			if (!line.empty() && line.front() != ' ') break;
+			if (flag == '1') result.enter = true;
+			if (flag == '2') result.leave = true;
+		}
+		return result;
+	}
+
+	std::vector<include_entry> read_includes(std::string_view text) {
+		std::vector<include_entry> result{};
+		std::vector<size_t> stack{};
+		// <built-in>, <command-line> and the like
+		bool pseudo_file{false};
+
+		auto const pop_to = [&](std::u8string const& path) {
+			for (auto index = stack.size(); index > 0; --index) {
+				if (result[stack[index - 1]].path != path) continue;
+				stack.resize(index);
+				return true;
+			}
+			return false;
+		};
+
+		size_t pos{};
+		while (pos < text.size()) {
+			auto const eol = text.find('\n', pos);
+			auto const next =
+			    eol == std::string_view::npos ? text.size() : eol + 1;
+			auto line = text.substr(pos, next - pos);
+			while (!line.empty() &&
+			       (line.back() == '\n' || line.back() == '\r'))
+				line.remove_suffix(1);
+
+			auto marker = read_linemarker(line);
+			if (!marker) {
+				if (!stack.empty() && !pseudo_file)
+					result[stack.back()].bytes += next - pos;
+				pos = next;
+				continue;
+			}
+			pos = next;
+
+			pseudo_file = marker->path.starts_with(u8'<');
+			if (marker->leave) {
+				if (!pop_to(marker->path) && stack.size() > 1) stack.pop_back();
+				continue;
+			}
+			if (pseudo_file || (!marker->enter && pop_to(marker->path)))
+				continue;
+
+			stack.push_back(result.size());
+			result.push_back({std::move(marker->path),
+			                  static_cast<std::uint32_t>(stack.size() - 1),
+			                  0});
+		}
+
+		return result;
+	}
+
 	struct decl_info {
 		bool module_export{false};
 		bool module_decl{false};
@@ -212,23 +318,19 @@ namespace {
 
 			if (info.module_decl) {
 				result.is_interface = info.module_export;
-				if (!info.module_export) {
-					result.imports.push_back({module_name, part_name});
-				}
-				result.name.module = std::move(module_name);
-				result.name.part = std::move(part_name);
+				result.name = mod_name{module_name, part_name};
+				if (!info.module_export) result.imports.push_back(result.name);
 				return;
 			}
 
 			if (info.module_import) {
 				if (info.legacy_header) {
 					if (!module_name.empty() && part_name.empty()) {
-						result.imports.push_back({std::move(module_name), {}});
+						result.imports.push_back(mod_name{module_name});
 					}
 					return;
 				}
-				result.imports.push_back(
-				    {std::move(module_name), std::move(part_name)});
+				result.imports.push_back(mod_name{module_name, part_name});
 				return;
 			}
 		}
@@ -257,19 +359,20 @@ module_unit cxx::scan(std::string_view text) {
 	hl::cxx::tokenize(cb.text, cb);
 
 	for (auto& import : unit.imports) {
-		if (import.part.empty()) continue;
-		if (!import.module.empty() || unit.name.module.empty()) {
-			import.module.clear();
-			import.part.clear();
+		if (import.part == symbol::empty) continue;
+		if (import.module != symbol::empty ||
+		    unit.name.module == symbol::empty) {
+			import = {};
 			continue;
 		}
 		import.module = unit.name.module;
 	}
 
-	auto it =
-	    std::remove_if(unit.imports.begin(), unit.imports.end(),
-	                   [](auto& import) { return import.module.empty(); });
+	auto it = std::remove_if(
+	    unit.imports.begin(), unit.imports.end(),
+	    [](auto& import) { return import.module == symbol::empty; });
 	unit.imports.erase(it, unit.imports.end());
 
+	unit.includes = read_includes(text);
 	return unit;
 }
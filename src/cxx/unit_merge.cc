@@ -0,0 +1,241 @@
+#include "cxx/unit_merge.hh"
+#include <algorithm>
+#include <cctype>
+
+using namespace std::literals;
+
+namespace cxx {
+	namespace {
+		bool is_space(char c) noexcept {
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+			       c == '\v' || c == '\f';
+		}
+
+		std::string_view trimmed(std::string_view text) {
+			while (!text.empty() && is_space(text.front()))
+				text.remove_prefix(1);
+			while (!text.empty() && is_space(text.back()))
+				text.remove_suffix(1);
+			return text;
+		}
+
+		// Lines of the source with the comments taken out; a block comment
+		// may go on over several lines.
+		struct line_reader {
+			std::string_view text{};
+			size_t pos{};
+			size_t line{1};
+			bool block_comment{false};
+
+			bool done() const noexcept { return pos >= text.size(); }
+
+			// code on the next line, without comments and outer spaces
+			std::string next() {
+				auto const eol = text.find('\n', pos);
+				auto const end =
+				    eol == std::string_view::npos ? text.size() : eol + 1;
+				auto rest = text.substr(pos, end - pos);
+				pos = end;
+				++line;
+
+				std::string code{};
+				while (!rest.empty()) {
+					if (block_comment) {
+						auto const stop = rest.find("*/"sv);
+						if (stop == std::string_view::npos) break;
+						rest.remove_prefix(stop + 2);
+						block_comment = false;
+						code.push_back(' ');
+						continue;
+					}
+					auto const start = rest.find('/');
+					if (start == std::string_view::npos ||
+					    start + 1 == rest.size()) {
+						code.append(rest);
+						break;
+					}
+					code.append(rest.substr(0, start));
+					if (rest[start + 1] == '/') break;
+					if (rest[start + 1] == '*') {
+						rest.remove_prefix(start + 2);
+						block_comment = true;
+						continue;
+					}
+					code.push_back('/');
+					rest.remove_prefix(start + 1);
+				}
+				return std::string{trimmed(code)};
+			}
+		};
+
+		bool is_name(std::string_view name) {
+			if (name.empty() || name.front() == '.' || name.back() == '.')
+				return false;
+			return std::all_of(name.begin(), name.end(), [](char c) {
+				return std::isalnum(static_cast<unsigned char>(c)) ||
+				       c == '_' || c == '.';
+			});
+		}
+
+		// `module X;`, with X not a partition; empty otherwise
+		std::string declared_module(std::string_view code) {
+			if (!code.starts_with("module"sv) || !code.ends_with(';'))
+				return {};
+			code.remove_prefix("module"sv.size());
+			code.remove_suffix(1);
+			if (code.empty() || !is_space(code.front())) return {};
+			code = trimmed(code);
+			if (!is_name(code)) return {};
+			return std::string{code};
+		}
+
+		bool is_import(std::string_view code) {
+			return code.starts_with("import"sv) && code.size() > 6 &&
+			       (is_space(code[6]) || code[6] == '<' || code[6] == '"') &&
+			       code.find(';') == code.size() - 1;
+		}
+
+		bool is_include(std::string_view code) {
+			if (!code.starts_with('#')) return false;
+			return trimmed(code.substr(1)).starts_with("include"sv);
+		}
+
+		void append_line(std::string& out,
+		                 size_t line,
+		                 std::string_view path) {
+			out.append("#line "sv);
+			out.append(std::to_string(line));
+			out.append(" \""sv);
+			for (auto const c : path) {
+				if (c == '"' || c == '\\') out.push_back('\\');
+				out.push_back(c);
+			}
+			out.append("\"\n"sv);
+		}
+
+		void append_part(std::string& out,
+		                 std::string_view part,
+		                 size_t line,
+		                 std::string_view path) {
+			if (trimmed(part).empty()) return;
+			append_line(out, line, path);
+			out.append(part);
+			if (!part.ends_with('\n')) out.push_back('\n');
+		}
+	}  // namespace
+
+	std::optional<unit_parts> split_unit(std::string_view text) {
+		unit_parts result{};
+		line_reader lines{text};
+
+		bool fragment{false};
+		bool directive{false};  // inside a directive, continued with '\'
+		int conditions{};       // #if... still open
+		while (true) {
+			if (lines.done()) return std::nullopt;
+			auto const start = lines.pos;
+			auto const line = lines.line;
+			auto const comment = lines.block_comment;
+			auto const code = lines.next();
+			if (directive) {
+				directive = code.ends_with('\\');
+				continue;
+			}
+			if (code.empty()) continue;
+
+			if (!fragment && code == "module;"sv) {
+				fragment = true;
+				result.fragment_line = line + 1;
+				result.fragment = text.substr(lines.pos, 0);
+				continue;
+			}
+			if (fragment && code.front() == '#') {
+				auto const name = trimmed(std::string_view{code}.substr(1));
+				if (name.starts_with("if"sv)) ++conditions;
+				if (name.starts_with("endif"sv)) --conditions;
+				directive = code.ends_with('\\');
+				continue;
+			}
+
+			// the declaration has to be all by itself
+			if (comment || lines.block_comment || conditions)
+				return std::nullopt;
+			result.module = declared_module(code);
+			if (result.module.empty()) return std::nullopt;
+			if (fragment) {
+				auto const from = static_cast<size_t>(
+				    result.fragment.data() - text.data());
+				result.fragment = text.substr(from, start - from);
+			}
+			break;
+		}
+
+		auto const imports = lines.pos;
+		result.imports_line = lines.line;
+		while (!lines.done()) {
+			auto const start = lines.pos;
+			auto const line = lines.line;
+			auto const comment = lines.block_comment;
+			auto code = lines.next();
+			if (code.empty() || is_import(code)) continue;
+
+			// the comment opened above goes with the rest
+			if (comment) return std::nullopt;
+			result.imports = text.substr(imports, start - imports);
+			result.body = text.substr(start);
+			result.body_line = line;
+
+			// imports further down, after a directive, would end up after
+			// the declarations of the units before; headers included here
+			// would meet the ones from the fragments of the others in the
+			// purview of the module
+			while (true) {
+				if (is_import(code) || is_include(code)) return std::nullopt;
+				if (lines.done()) return result;
+				code = lines.next();
+			}
+		}
+
+		if (lines.block_comment) return std::nullopt;
+		result.imports = text.substr(imports);
+		result.body_line = lines.line;
+		return result;
+	}
+
+	std::optional<std::string> merge_units(
+	    std::vector<unit_source> const& units) {
+		std::vector<unit_parts> parts{};
+		parts.reserve(units.size());
+		for (auto const& unit : units) {
+			auto split = split_unit(unit.text);
+			if (!split) return std::nullopt;
+			if (!parts.empty() && split->module != parts.front().module)
+				return std::nullopt;
+			parts.push_back(std::move(*split));
+		}
+		if (parts.empty()) return std::nullopt;
+
+		std::string result{};
+		auto const has_fragment =
+		    std::any_of(parts.begin(), parts.end(), [](auto const& part) {
+			    return !trimmed(part.fragment).empty();
+		    });
+		if (has_fragment) {
+			result.append("module;\n"sv);
+			for (size_t index = 0; index < parts.size(); ++index)
+				append_part(result, parts[index].fragment,
+				            parts[index].fragment_line, units[index].path);
+		}
+
+		result.append("module "sv);
+		result.append(parts.front().module);
+		result.append(";\n"sv);
+		for (size_t index = 0; index < parts.size(); ++index)
+			append_part(result, parts[index].imports,
+			            parts[index].imports_line, units[index].path);
+		for (size_t index = 0; index < parts.size(); ++index)
+			append_part(result, parts[index].body, parts[index].body_line,
+			            units[index].path);
+		return result;
+	}
+}  // namespace cxx
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cxx {
+	// Module implementation unit, split around its `module X;` line. Only
+	// the plain layout is recognized: an optional global module fragment
+	// of preprocessor directives, the declaration on a line of its own,
+	// then the imports, each on a line of their own, then the rest.
+	struct unit_parts {
+		std::string module{};
+		std::string_view fragment{};  // without the `module;` line
+		std::string_view imports{};
+		std::string_view body{};
+		size_t fragment_line{};
+		size_t imports_line{};
+		size_t body_line{};
+	};
+
+	std::optional<unit_parts> split_unit(std::string_view text);
+
+	struct unit_source {
+		std::string path{};
+		std::string text{};
+	};
+
+	// Implementation units of one module as a single translation unit:
+	// the fragments, one module declaration, the imports, then the rest of
+	// each unit, with #line directives pointing back at the sources. Empty,
+	// if one of them cannot be split or declares another module.
+	std::optional<std::string> merge_units(
+	    std::vector<unit_source> const& units);
+}  // namespace cxx
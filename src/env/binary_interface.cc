@@ -1,4 +1,7 @@
 #include "env/binary_interface.hh"
+#include <env/defaults.hh>
+#include <algorithm>
+#include <set>
 
 namespace env {
 	namespace {
@@ -19,22 +22,27 @@ namespace env {
 	binary_interface::binary_interface(bool supports_paritions,
 	                                   bool standalone_interface,
 	                                   std::filesystem::path const& dirname,
-	                                   std::filesystem::path const& ext)
+	                                   std::filesystem::path const& ext,
+	                                   std::u8string_view module_file_flag,
+	                                   std::u8string_view mapper_flag)
 	    : partition_separator_{supports_paritions ? u8'-' : u8'.'}
 	    , standalone_interface_{standalone_interface}
 	    , dirname_{append(u8'/', dirname)}
-	    , ext_{prepend(u8'.', ext)} {}
+	    , ext_{prepend(u8'.', ext)}
+	    , module_file_flag_{module_file_flag}
+	    , mapper_flag_{mapper_flag} {}
 
-	std::u8string binary_interface::as_interface(mod_name const& name) {
+	std::u8string binary_interface::as_interface(mod_name const& name) const {
+		auto const& module = str(name.module);
+		auto const& part = str(name.part);
 		std::u8string fname{};
-		fname.reserve(dirname_.size() + name.module.size() +
-		              (name.part.empty() ? 0 : 1 + name.part.size()) +
-		              ext_.size());
+		fname.reserve(dirname_.size() + module.size() +
+		              (part.empty() ? 0 : 1 + part.size()) + ext_.size());
 		fname.append(dirname_);
-		fname.append(name.module);
-		if (!name.part.empty()) {
+		fname.append(module);
+		if (!part.empty()) {
 			fname.push_back(partition_separator_);
-			fname.append(name.part);
+			fname.append(part);
 		}
 		fname.append(ext_);
 		return fname;
@@ -44,13 +52,233 @@ namespace env {
 	    include_locator& locator,
 	    std::filesystem::path const& source_path,
 	    mod_name const& ref) {
-		if (!ref.module.empty() &&
-		    (ref.module.front() == u8'<' || ref.module.front() == u8'"')) {
+		auto const& module = str(ref.module);
+		if (!module.empty() &&
+		    (module.front() == u8'<' || module.front() == u8'"')) {
 			return header_module(locator, source_path, ref);
 		}
+		if (std_decls_.count(ref) && use_std(locator, ref)) {
+			for (auto const& dep : std_deps(ref))
+				use_std(locator, dep);
+		}
 		return mod_ref{ref, as_interface(ref)};
 	}
 
+	void binary_interface::set_std_modules(
+	    std::filesystem::path const& cache,
+	    std::map<mod_name, std_source> sources) {
+		std_decls_ = std::move(sources);
+		std_cache_ = append(u8'/', cache);
+	}
+
+	std::u8string_view binary_interface::std_flags(var flags) noexcept {
+		switch (flags) {
+			case var::CFLAGS:
+				return u8"-O2"sv;
+			case var::CXXFLAGS:
+				return u8"-std=c++20"sv;
+			default:
+				break;
+		}
+		return {};
+	}
+
+	bool binary_interface::use_std(include_locator& locator,
+	                               mod_name const& name) {
+		if (std_sources_.count(name)) return true;
+		auto it = std_decls_.find(name);
+		if (it == std_decls_.end()) return false;
+
+		auto path = it->second.path;
+		if (!it->second.include.empty()) {
+			path = locator.find_include(
+			    {}, u8"<"s + it->second.include + u8">"s);
+		}
+		std::error_code ec{};
+		if (path.empty() || !std::filesystem::is_regular_file(path, ec)) {
+			std::cerr << "c++modules: warning: cannot find sources of module "
+			          << as_sv(name.toString()) << '\n';
+			std_decls_.erase(it);
+			return false;
+		}
+
+		if (std_sources_.empty()) write_std_mapper();
+		std_sources_[name] = path.lexically_normal();
+		return true;
+	}
+
+	void binary_interface::write_std_mapper() {
+		if (mapper_flag_.empty()) return;
+
+		std::filesystem::path const cache{std_cache_};
+		auto const mapper = cache / u8"std.mapper"sv;
+		std::error_code ec{};
+		std::filesystem::create_directories(cache, ec);
+		auto file = fs::fopen(mapper, "wb");
+		if (ec || !file) {
+			std::cerr << "c++modules: warning: cannot write "
+			          << as_sv(mapper.generic_u8string()) << '\n';
+			return;
+		}
+		for (auto const& [name, _] : std_decls_) {
+			file.print(as_sv(name.toString()));
+			file.putc(' ');
+			file.print(as_sv(std_cached(name, ext_)));
+			file.putc('\n');
+		}
+		std_mapper_ = mapper_flag_ + mapper.generic_u8string();
+	}
+
+	void binary_interface::module_map(target& edge,
+	                                  std::filesystem::path const& stem,
+	                                  std::vector<artifact> const& imports,
+	                                  std::optional<mod_ref> const& exported,
+	                                  header_names const& names) const {
+		auto const is_mapper = !mapper_flag_.empty();
+		if (!is_mapper && module_file_flag_.empty()) return;
+
+		// without a map, a side-effect compiler looks for header units in
+		// the BMI dir on every #include; the others have nothing to find
+		auto const listed = [](artifact const& input) {
+			return std::holds_alternative<mod_ref>(input) ||
+			       std::get<file_ref>(input).type == file_ref::header_module;
+		};
+		if (!is_mapper && std::none_of(imports.begin(), imports.end(), listed))
+			return;
+
+		auto root = dirname_;
+		if (!root.empty()) root.pop_back();
+
+		// interfaces record their own imports relative to the root of the
+		// module mapper used to build them, which is the BMI dir; the
+		// other paths in the binary dir are taken from there too, and only
+		// the ones outside of it, like the standard modules, stay absolute
+		auto const relative = [&](std::u8string_view bmi) -> std::u8string {
+			if (!is_mapper) return std::u8string{bmi};
+			if (bmi.starts_with(dirname_)) {
+				bmi.remove_prefix(dirname_.size());
+				return std::u8string{bmi};
+			}
+			std::filesystem::path const path{bmi};
+			if (path.is_absolute()) return std::u8string{bmi};
+			return path.lexically_relative(root).generic_u8string();
+		};
+
+		std::string contents{};
+		auto const line = [&](std::u8string_view name,
+		                      std::u8string_view bmi) {
+			if (is_mapper) {
+				contents.append(as_sv(name));
+				contents.push_back(' ');
+			} else {
+				contents.append(as_sv(module_file_flag_));
+				if (!name.empty()) {
+					contents.append(as_sv(name));
+					contents.push_back('=');
+				}
+			}
+			contents.append(as_sv(relative(bmi)));
+			contents.push_back('\n');
+		};
+
+		if (is_mapper) {
+			contents.append("$root ").append(as_sv(root)).push_back('\n');
+			if (exported) line(exported->mod.toString(), exported->path);
+		}
+		for (auto const& input : imports) {
+			if (std::holds_alternative<mod_ref>(input)) {
+				auto const& mod = std::get<mod_ref>(input);
+				line(mod.mod.toString(), mod.path);
+				continue;
+			}
+			// header units are known to the compiler by their paths
+			auto const& ref = std::get<file_ref>(input);
+			if (ref.type != file_ref::header_module) continue;
+			if (!is_mapper) {
+				line({}, ref.path);
+				continue;
+			}
+			auto it = header_modules_.find(ref.path);
+			if (it != header_modules_.end())
+				line(std::get<0>(it->second), ref.path);
+		}
+		if (is_mapper) {
+			// a relative name is asked for with a leading "./"
+			for (auto const& [name, bmi] : names) {
+				if (name.starts_with(u8'/') || name.starts_with(u8"./"sv))
+					line(name, bmi);
+				else
+					line(u8"./"s + name, bmi);
+			}
+		}
+
+		auto path = stem;
+		path += is_mapper ? u8".map"sv : u8".rsp"sv;
+		if (is_mapper)
+			edge.vars.push_back(
+			    {"MODULE_MAPPER"s, mapper_flag_ + path.generic_u8string()});
+		else
+			edge.vars.push_back(
+			    {"MODULE_FILES"s, u8"@"s + path.generic_u8string()});
+		edge.files.push_back({std::move(path), std::move(contents)});
+	}
+
+	void binary_interface::set_module_output(std::u8string_view flag,
+	                                         std::u8string_view reduced_flag) {
+		module_output_flag_.assign(flag);
+		reduced_bmi_flag_.assign(reduced_flag);
+	}
+
+	std::u8string binary_interface::module_output(mod_name const& name) const {
+		std::u8string result{};
+		if (module_output_flag_.empty()) return result;
+		if (!reduced_bmi_flag_.empty()) {
+			result.append(reduced_bmi_flag_);
+			result.push_back(u8' ');
+		}
+		result.append(module_output_flag_);
+		result.append(as_interface(name));
+		return result;
+	}
+
+	std::vector<artifact> binary_interface::std_objects(
+	    std::vector<mod_name> const& imports) const {
+		std::set<mod_name> linked{};
+		for (auto const& import : imports) {
+			if (!std_sources_.count(import)) continue;
+			linked.insert(import);
+			for (auto const& dep : std_deps(import))
+				if (std_sources_.count(dep)) linked.insert(dep);
+		}
+
+		std::vector<artifact> result{};
+		result.reserve(linked.size());
+		for (auto const& name : linked) {
+			auto const object =
+			    env::path_mods().object.modify(name.toString());
+			result.push_back(file_ref{
+			    0, std_cached(name, {}) + object.generic_u8string(),
+			    file_ref::external});
+		}
+		return result;
+	}
+
+	std::vector<mod_name> binary_interface::std_deps(
+	    mod_name const& name) const {
+		// std.compat re-exports std
+		mod_name const std_module{u8"std"sv};
+		if (name == std_module || !std_decls_.count(name) ||
+		    !std_decls_.count(std_module))
+			return {};
+		return {std_module};
+	}
+
+	std::u8string binary_interface::std_cached(mod_name const& name,
+	                                           std::u8string_view ext) const {
+		if (ext.empty()) return std_cache_;
+		return std_cache_ + name.toString() + as_u8str(ext);
+	}
+
 	void binary_interface::add_targets(std::vector<target>& targets,
 	                                   rule_types& rules_needed) const {
 		for (auto const& [bmi_file, sources] : header_modules_) {
@@ -68,15 +296,78 @@ namespace env {
 			             std::get<2>(sources)},
 			});
 		}
+
+		add_std_targets(targets, rules_needed);
+	}
+
+	void binary_interface::add_std_targets(std::vector<target>& targets,
+	                                       rule_types& rules_needed) const {
+		// Shared by all build dirs, so missing from most .ninja_logs and
+		// deps logs; rebuilt only when older than the sources. The flags
+		// are the ones in the name of the cache, not the build dir's.
+		std::vector<std::pair<std::string, std::u8string>> const shared{
+		    {"generator"s, u8"1"s},
+		    {"depfile"s, {}},
+		    {"deps"s, {}},
+		    {"DEFINES"s, as_u8str(std_flags(var::DEFINES))},
+		    {"CFLAGS"s, as_u8str(std_flags(var::CFLAGS))},
+		    {"CXXFLAGS"s, as_u8str(std_flags(var::CXXFLAGS))},
+		};
+
+		for (auto const& [name, path] : std_sources_) {
+			file_ref const source{0, path.generic_u8string(),
+			                      file_ref::external};
+			mod_ref const cached{name, std_cached(name, ext_)};
+
+			std::vector<artifact> deps{};
+			for (auto const& dep : std_deps(name)) {
+				if (std_sources_.count(dep))
+					deps.push_back(mod_ref{dep, std_cached(dep, ext_)});
+			}
+
+			if (standalone_interface_) {
+				rules_needed.set(rule_type::EMIT_BMI);
+				target bmi{rule_type::EMIT_BMI, cached};
+				bmi.inputs.expl.push_back(source);
+				bmi.inputs.impl = deps;
+				bmi.vars = shared;
+				targets.push_back(std::move(bmi));
+			}
+
+			rules_needed.set(rule_type::COMPILE);
+			target object{rule_type::COMPILE, std_objects({name}).back()};
+			object.inputs.expl.push_back(source);
+			object.inputs.impl = deps;
+			if (!standalone_interface_) {
+				object.outputs.impl.push_back(cached);
+				object.edge = name.toString();
+				if (!std_mapper_.empty())
+					object.vars.push_back({"MODULE_MAPPER"s, std_mapper_});
+			}
+			object.vars.insert(object.vars.end(), shared.begin(),
+			                   shared.end());
+			targets.push_back(std::move(object));
+
+			rules_needed.set(rule_type::COPY_BMI);
+			target copy{rule_type::COPY_BMI,
+			            mod_ref{name, as_interface(name)}};
+			copy.inputs.expl.push_back(cached);
+			targets.push_back(std::move(copy));
+		}
 	}
 
 	std::optional<artifact> binary_interface::header_module(
 	    include_locator& locator,
 	    std::filesystem::path const& source_path,
 	    mod_name const& ref) {
-		auto const path = locator.find_include(source_path, ref.module);
+		auto const& module = str(ref.module);
+		auto const path = locator.find_include(source_path, module);
 		if (path.empty()) return std::nullopt;
+		return header_unit(path, module);
+	}
 
+	file_ref binary_interface::header_unit(std::filesystem::path const& path,
+	                                       std::u8string_view name) {
 		auto const bmi_rel = path.relative_path().generic_u8string() + ext_;
 		std::u8string bmi{};
 		bmi.reserve(dirname_.size() + bmi_rel.size());
@@ -87,9 +378,32 @@ namespace env {
 		header_modules_[bmi] = {
 		    path.generic_u8string(),
 		    bmi_node_name,
-		    ref.module,
+		    as_u8str(name),
 		};
 		return file_ref{0, std::move(bmi), file_ref::header_module,
 		                bmi_node_name};
 	}
+
+	std::u8string binary_interface::module_file_flags(
+	    std::vector<artifact> const& inputs) const {
+		std::u8string result{};
+		if (module_file_flag_.empty()) return result;
+		auto const add = [&](std::u8string const& path) {
+			if (!result.empty()) result.push_back(u8' ');
+			result.append(module_file_flag_);
+			result.append(path);
+		};
+		for (auto const& input : inputs) {
+			if (std::holds_alternative<mod_ref>(input)) {
+				// only the interfaces kept in the cache need to be named
+				auto const& mod = std::get<mod_ref>(input);
+				if (!std_cache_.empty() && mod.path.starts_with(std_cache_))
+					add(mod.path);
+				continue;
+			}
+			auto const& file = std::get<file_ref>(input);
+			if (file.type == file_ref::header_module) add(file.path);
+		}
+		return result;
+	}
 }  // namespace env
@@ -6,16 +6,23 @@
 #include <env/include_locator.hh>
 #include <filesystem>
 #include <iostream>
+#include <map>
 #include <optional>
 #include <string>
 
 namespace env {
+	// other names of header units, as (name, BMI) pairs
+	using header_names =
+	    std::vector<std::pair<std::u8string, std::u8string>>;
+
 	class binary_interface {
 	public:
 		binary_interface(bool supports_paritions,
 		                 bool standalone_interface,
 		                 std::filesystem::path const& dirname,
-		                 std::filesystem::path const& ext);
+		                 std::filesystem::path const& ext,
+		                 std::u8string_view module_file_flag = {},
+		                 std::u8string_view mapper_flag = {});
 
 		friend std::ostream& operator<<(std::ostream& out,
 		                                binary_interface const& biin) {
@@ -31,15 +38,95 @@ namespace env {
 		bool standalone_interface() const noexcept {
 			return standalone_interface_;
 		}
-		std::u8string as_interface(mod_name const& name);
+		std::u8string as_interface(mod_name const& name) const;
 		std::optional<artifact> from_module(
 		    include_locator& locator,
 		    std::filesystem::path const& source_path,
 		    mod_name const& ref);
+		// header unit for an already located header; `name` is the header
+		// as it would be spelled in an import, quotes or brackets included
+		file_ref header_unit(std::filesystem::path const& path,
+		                     std::u8string_view name);
+		// A compiler with a module mapper asks it whether an #include
+		// can become an import of a header unit; the others never turn
+		// one into an import.
+		bool translates_includes() const noexcept {
+			return !mapper_flag_.empty();
+		}
+		// flags telling the compiler about header units used by an edge,
+		// one per unit; empty, if the compiler finds them by itself
+		std::u8string module_file_flags(
+		    std::vector<artifact> const& inputs) const;
 		void add_targets(std::vector<target>& targets,
 		                 rule_types& rules_needed) const;
 
+		// Where to find the sources of a standard library module: either
+		// a header name to look up in system include dirs, or a path.
+		struct std_source {
+			std::u8string include{};
+			std::filesystem::path path{};
+		};
+
+		// Standard library modules ("std", "std.compat") are built from
+		// the toolchain's sources once, into the `cache` directory shared
+		// by all build dirs, and copied from there into the build, where
+		// the importers look for any other interface. A side-effect
+		// compiler is pointed at the cache with a module mapper file.
+		void set_std_modules(std::filesystem::path const& cache,
+		                     std::map<mod_name, std_source> sources);
+		// DEFINES, CFLAGS and CXXFLAGS the standard library modules are
+		// built with, in every build dir alike
+		static std::u8string_view std_flags(var flags) noexcept;
+		// objects of the standard library modules among the imports, to
+		// be linked in
+		std::vector<artifact> std_objects(
+		    std::vector<mod_name> const& imports) const;
+
+		// Lists the interfaces an edge may read, `imports`, and the one it
+		// writes, `exported`, in a file at `stem` plus an extension, so
+		// the compiler looks for no other: a module mapper, if there is a
+		// mapper flag, or else a response file with a module-file flag
+		// for each interface. A mapper also lists the header units under
+		// the `names` the compiler looks them up by for this edge, and
+		// gives the paths in the binary dir relative to its root. The file
+		// goes to the files of the `edge`, the edge variable naming it,
+		// MODULE_MAPPER or MODULE_FILES, to its variables; the edge is
+		// left alone, if the compiler takes neither.
+		void module_map(target& edge,
+		                std::filesystem::path const& stem,
+		                std::vector<artifact> const& imports,
+		                std::optional<mod_ref> const& exported = std::nullopt,
+		                header_names const& names = {}) const;
+		// A side-effect compiler can have the interface written by its own
+		// interface-only edge; the object of the interface is then built
+		// with a module map sending the interface it writes again
+		// elsewhere, away from the importers.
+		bool redirects_interfaces() const noexcept {
+			return !mapper_flag_.empty();
+		}
+
+		// A direct compiler may also write the interface while compiling
+		// the object, if told where with `flag`; `reduced_flag` asks for
+		// the smaller interface, only available that way.
+		void set_module_output(std::u8string_view flag,
+		                       std::u8string_view reduced_flag);
+		bool writes_module_output() const noexcept {
+			return !module_output_flag_.empty();
+		}
+		// flags for a COMPILE edge writing the interface of `name`
+		std::u8string module_output(mod_name const& name) const;
+
+		// standard library modules imported by standard module `name`
+		std::vector<mod_name> std_deps(mod_name const& name) const;
+
 	private:
+		void add_std_targets(std::vector<target>& targets,
+		                     rule_types& rules_needed) const;
+		bool use_std(include_locator& locator, mod_name const& name);
+		void write_std_mapper();
+		std::u8string std_cached(mod_name const& name,
+		                         std::u8string_view ext) const;
+
 		std::optional<artifact> header_module(
 		    include_locator& locator,
 		    std::filesystem::path const& source_path,
@@ -49,9 +136,18 @@ namespace env {
 		bool standalone_interface_;
 		std::u8string dirname_;
 		std::u8string ext_;
+		std::u8string module_file_flag_;
+		std::u8string mapper_flag_;
+		std::u8string module_output_flag_{};
+		std::u8string reduced_bmi_flag_{};
 
 		std::map<std::u8string,
 		         std::tuple<std::u8string, std::u8string, std::u8string>>
 		    header_modules_{};
+
+		std::u8string std_cache_{};
+		std::u8string std_mapper_{};
+		std::map<mod_name, std_source> std_decls_{};
+		std::map<mod_name, std::filesystem::path> std_sources_{};
 	};
 }  // namespace env
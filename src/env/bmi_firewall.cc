@@ -0,0 +1,192 @@
+#include "env/bmi_firewall.hh"
+#include <base/utils.hh>
+#include <algorithm>
+#include <iostream>
+
+using namespace std::literals;
+
+namespace env {
+	namespace {
+		fs::path saved(fs::path const& bmi) {
+			auto result = bmi;
+			result += u8".prev"sv;
+			return result;
+		}
+
+		fs::path fingerprint_of(fs::path const& bmi) {
+			auto result = bmi;
+			result += u8".fp"sv;
+			return result;
+		}
+
+		bool same_contents(fs::path const& lhs, fs::path const& rhs) {
+			std::error_code ec{};
+			auto const size = fs::file_size(lhs, ec);
+			if (ec || size != fs::file_size(rhs, ec) || ec) return false;
+
+			auto left = fs::fopen(lhs, "rb");
+			auto right = fs::fopen(rhs, "rb");
+			if (!left || !right) return false;
+
+			char lbuffer[16384];
+			char rbuffer[sizeof(lbuffer)];
+			while (true) {
+				auto const lread = left.load(lbuffer, sizeof(lbuffer));
+				auto const rread = right.load(rbuffer, sizeof(rbuffer));
+				if (lread != rread) return false;
+				if (!lread) return true;
+				if (!std::equal(lbuffer, lbuffer + lread, rbuffer)) return false;
+			}
+		}
+
+		bool fingerprint_matches(fs::path const& bmi,
+		                         std::string_view fingerprint,
+		                         std::span<fs::path const> inputs) {
+			auto const fp_path = fingerprint_of(bmi);
+			auto const stored = fs::fopen(fp_path, "rb").read();
+			if (std::string_view{stored.data(), stored.size()} != fingerprint)
+				return false;
+
+			std::error_code ec{};
+			auto const since = fs::last_write_time(fp_path, ec);
+			if (ec) return false;
+			for (auto const& input : inputs) {
+				auto const mtime = fs::last_write_time(input, ec);
+				if (ec || mtime > since) return false;
+			}
+			return true;
+		}
+
+		void report(char const* action,
+		            fs::path const& path,
+		            std::error_code const& ec) {
+			std::cerr << "c++modules: error: cannot " << action << ' '
+			          << as_sv(path.generic_u8string()) << ": " << ec.message()
+			          << '\n';
+		}
+	}  // namespace
+
+	bool save_interfaces(std::span<fs::path const> bmis) {
+		bool result = true;
+		for (auto const& bmi : bmis) {
+			std::error_code ec{};
+			if (!fs::exists(bmi, ec)) continue;
+			fs::rename(bmi, saved(bmi), ec);
+			if (ec) {
+				report("move aside", bmi, ec);
+				result = false;
+			}
+		}
+		return result;
+	}
+
+	bool restore_interfaces(std::span<fs::path const> bmis) {
+		bool result = true;
+		for (auto const& bmi : bmis) {
+			auto const prev = saved(bmi);
+			std::error_code ec{};
+			if (!fs::exists(prev, ec)) continue;
+
+			if (same_contents(bmi, prev)) {
+				fs::rename(prev, bmi, ec);
+				if (ec) {
+					report("restore", bmi, ec);
+					result = false;
+				}
+			} else {
+				fs::remove(prev, ec);
+			}
+		}
+		return result;
+	}
+
+	std::vector<fs::path> read_depfile(fs::path const& depfile) {
+		auto const contents = fs::fopen(depfile, "rb").read();
+		std::string_view text{contents.data(), contents.size()};
+
+		std::vector<fs::path> result{};
+		std::string name{};
+		bool targets = true;
+		auto const next = [&] {
+			if (name.empty()) return;
+			if (targets) {
+				if (name.back() == ':') targets = false;
+			} else {
+				result.emplace_back(as_u8sv(name));
+			}
+			name.clear();
+		};
+
+		for (size_t pos = 0; pos < text.size(); ++pos) {
+			auto const c = text[pos];
+			if (c == '\\' && pos + 1 < text.size()) {
+				auto const escaped = text[pos + 1];
+				if (escaped == ' ' || escaped == '#' || escaped == '\\') {
+					name.push_back(escaped);
+					++pos;
+					continue;
+				}
+				if (escaped == '\n' || escaped == '\r') {
+					next();
+					++pos;
+					if (escaped == '\r' && pos + 1 < text.size() &&
+					    text[pos + 1] == '\n')
+						++pos;
+					continue;
+				}
+			}
+			if (c == '$' && pos + 1 < text.size() && text[pos + 1] == '$') {
+				name.push_back('$');
+				++pos;
+				continue;
+			}
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+				next();
+				if (c == '\n') targets = true;
+				continue;
+			}
+			if (c == ':' && targets && pos + 1 < text.size() &&
+			    (text[pos + 1] == ' ' || text[pos + 1] == '\n' ||
+			     text[pos + 1] == '\r')) {
+				name.push_back(c);
+				next();
+				continue;
+			}
+			name.push_back(c);
+		}
+		next();
+
+		return result;
+	}
+
+	bool guard_interfaces(std::string_view fingerprint,
+	                      std::span<fs::path const> bmis,
+	                      std::span<fs::path const> inputs) {
+		bool result = true;
+		for (auto const& bmi : bmis) {
+			auto const prev = saved(bmi);
+			std::error_code ec{};
+			if (fs::exists(prev, ec) &&
+			    fingerprint_matches(bmi, fingerprint, inputs)) {
+				fs::rename(prev, bmi, ec);
+				if (ec) {
+					report("restore", bmi, ec);
+					result = false;
+				}
+				continue;
+			}
+
+			if (!restore_interfaces({&bmi, 1})) result = false;
+
+			auto const fp_path = fingerprint_of(bmi);
+			auto file = fs::fopen(fp_path, "wb");
+			if (!file || file.store(fingerprint.data(), fingerprint.size()) !=
+			                 fingerprint.size()) {
+				std::cerr << "c++modules: error: cannot write "
+				          << as_sv(fp_path.generic_u8string()) << '\n';
+				result = false;
+			}
+		}
+		return result;
+	}
+}  // namespace env
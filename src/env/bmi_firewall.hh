@@ -0,0 +1,26 @@
+#pragma once
+
+#include <fs/file.hh>
+#include <span>
+
+namespace env {
+	// Compare-and-swap around a command rebuilding module interfaces. The
+	// old files are moved aside before the command runs; afterwards, each
+	// one found byte-identical to its replacement is moved back, bringing
+	// its old timestamp along. With ninja's restat, the importers of an
+	// interface which did not really change are left alone.
+	bool save_interfaces(std::span<fs::path const> bmis);
+	bool restore_interfaces(std::span<fs::path const> bmis);
+
+	// Like restore_interfaces(), but an old BMI is also kept when the
+	// fingerprint of its source and command matches the one stored next
+	// to it (in "<bmi>.fp") and none of the other inputs (imported BMIs,
+	// headers) is newer than that. Otherwise, the fingerprint is stored
+	// anew.
+	bool guard_interfaces(std::string_view fingerprint,
+	                      std::span<fs::path const> bmis,
+	                      std::span<fs::path const> inputs);
+
+	// Prerequisites listed in a Makefile-style depfile, as written by -MD.
+	std::vector<fs::path> read_depfile(fs::path const& depfile);
+}  // namespace env
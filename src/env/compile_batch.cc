@@ -0,0 +1,91 @@
+#include "env/compile_batch.hh"
+#include <base/utils.hh>
+#include <env/bmi_firewall.hh>
+#include <env/path.hh>
+#include <iostream>
+#include <process.hpp>
+#include <set>
+
+using namespace std::literals;
+
+namespace env {
+	namespace {
+		std::string escaped(std::u8string_view path) {
+			std::string result{};
+			for (auto const c : as_sv(path)) {
+				if (c == ' ' || c == '#' || c == '\\') result.push_back('\\');
+				if (c == '$') result.push_back('$');
+				result.push_back(c);
+			}
+			return result;
+		}
+	}  // namespace
+
+	int compile_batch(std::vector<std::string> command,
+	                  std::span<fs::path const> sources,
+	                  std::span<fs::path const> objects,
+	                  fs::path const& depfile) {
+		if (command.empty() || objects.empty() ||
+		    sources.size() != objects.size()) {
+			std::cerr << "c++modules: error: expecting one object for each "
+			             "source of the batch\n";
+			return 1;
+		}
+
+		command.front() =
+		    as_str(which(as_u8sv(command.front())).generic_u8string());
+
+		TinyProcessLib::Process compile{
+		    command, "",
+		    [](const char* bytes, size_t n) {
+			    std::cout.write(bytes, static_cast<std::streamsize>(n));
+		    },
+		    [](const char* bytes, size_t n) {
+			    std::cerr.write(bytes, static_cast<std::streamsize>(n));
+		    }};
+		auto status = compile.get_exit_status();
+
+		std::string deps{escaped(objects.front().generic_u8string())};
+		deps.push_back(':');
+		std::set<fs::path> seen{};
+		for (size_t index = 0; index < sources.size(); ++index) {
+			auto stem = sources[index].stem();
+			auto object = stem;
+			object += u8".o"sv;
+			stem += u8".d"sv;
+
+			for (auto const& dep : read_depfile(stem)) {
+				if (!seen.insert(dep).second) continue;
+				deps.append(" \\\n  "sv);
+				deps.append(escaped(dep.generic_u8string()));
+			}
+
+			std::error_code ec{};
+			fs::remove(stem, ec);
+			if (status != 0) {
+				fs::remove(object, ec);
+				continue;
+			}
+			fs::rename(object, objects[index], ec);
+			if (ec) {
+				std::cerr << "c++modules: error: cannot move "
+				          << as_sv(object.generic_u8string()) << " to "
+				          << as_sv(objects[index].generic_u8string()) << ": "
+				          << ec.message() << '\n';
+				status = 1;
+			}
+		}
+		if (status != 0) return status;
+
+		deps.push_back('\n');
+		std::error_code ec{};
+		fs::create_directories(depfile.parent_path(), ec);
+		auto file = fs::fopen(depfile, "wb");
+		if (!file || file.store(deps.data(), deps.size()) != deps.size()) {
+			std::cerr << "c++modules: error: cannot write "
+			          << as_sv(depfile.generic_u8string()) << '\n';
+			return 1;
+		}
+		return 0;
+	}
+}  // namespace env
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <fs/file.hh>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace env {
+	// Compiles several sources with a single compiler process. The command
+	// is the one for a single source, without -o and -MF, and with all the
+	// sources. The compiler then writes <stem>.o and <stem>.d into the
+	// current directory: the objects are moved where they belong and the
+	// depfiles merged into `depfile`, under the first object. Gives the
+	// exit status of the compiler.
+	int compile_batch(std::vector<std::string> command,
+	                  std::span<fs::path const> sources,
+	                  std::span<fs::path const> objects,
+	                  fs::path const& depfile);
+}  // namespace env
@@ -0,0 +1,283 @@
+#include "env/module_mapper.hh"
+#include <base/utils.hh>
+#include <env/path.hh>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <process.hpp>
+#include <thread>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+// The protocol is line-based: a block of requests is sent with all lines
+// but the last ending in " ;", and answered the same way, one response
+// per request. Words containing anything unusual are single-quoted, with
+// backslash escapes.
+namespace env {
+	namespace {
+		std::vector<std::string> words(std::string_view line) {
+			std::vector<std::string> result{};
+			size_t index = 0;
+			while (index < line.size()) {
+				if (line[index] == ' ') {
+					++index;
+					continue;
+				}
+
+				auto& word = result.emplace_back();
+				while (index < line.size() && line[index] != ' ') {
+					if (line[index] != '\'') {
+						word.push_back(line[index++]);
+						continue;
+					}
+					++index;
+					while (index < line.size() && line[index] != '\'') {
+						if (line[index] == '\\' && index + 1 < line.size()) {
+							++index;
+							auto const c = line[index];
+							word.push_back(c == 'n' ? '\n'
+							               : c == 't' ? '\t'
+							                          : c);
+						} else {
+							word.push_back(line[index]);
+						}
+						++index;
+					}
+					++index;
+				}
+			}
+			return result;
+		}
+
+		std::string quoted(std::string_view word) {
+			auto const plain = [](char c) {
+				return std::isalnum(static_cast<unsigned char>(c)) ||
+				       "-_./+,:@="sv.find(c) != std::string_view::npos;
+			};
+			if (!word.empty() && std::all_of(word.begin(), word.end(), plain))
+				return std::string{word};
+
+			std::string result{"'"};
+			for (auto const c : word) {
+				if (c == '\'' || c == '\\') result.push_back('\\');
+				result.push_back(c);
+			}
+			result.push_back('\'');
+			return result;
+		}
+
+		std::string pathname(std::u8string_view path) {
+			return "PATHNAME "s + quoted(as_sv(path));
+		}
+
+		std::string error(std::string_view message) {
+			return "ERROR "s + quoted(message);
+		}
+
+		struct block_reader {
+			std::vector<std::string> block{};
+
+			// true, if the line ends the block
+			bool add(std::string line) {
+				if (!line.empty() && line.back() == '\r') line.pop_back();
+				auto const more = line.ends_with(" ;"sv);
+				if (more) line.resize(line.size() - 2);
+				block.push_back(std::move(line));
+				return !more;
+			}
+		};
+
+		std::string joined(std::vector<std::string> const& responses) {
+			std::string result{};
+			for (auto const& response : responses) {
+				if (!result.empty()) result.append(" ;\n"sv);
+				result.append(response);
+			}
+			result.push_back('\n');
+			return result;
+		}
+
+#ifndef _WIN32
+		bool write_all(int fd, std::string_view text) {
+			while (!text.empty()) {
+				auto const written = ::write(fd, text.data(), text.size());
+				if (written <= 0) return false;
+				text.remove_prefix(static_cast<size_t>(written));
+			}
+			return true;
+		}
+
+		void serve_client(module_mapper& mapper, int fd) {
+			block_reader reader{};
+			std::string pending{};
+			char buffer[4096];
+			while (true) {
+				auto const size = ::read(fd, buffer, sizeof(buffer));
+				if (size <= 0) break;
+				pending.append(buffer, static_cast<size_t>(size));
+
+				size_t newline{};
+				while ((newline = pending.find('\n')) != std::string::npos) {
+					auto line = pending.substr(0, newline);
+					pending.erase(0, newline + 1);
+					if (!reader.add(std::move(line))) continue;
+					auto const text = joined(mapper.answer(reader.block));
+					reader.block.clear();
+					if (!write_all(fd, text)) {
+						::close(fd);
+						return;
+					}
+				}
+			}
+			::close(fd);
+		}
+#endif
+	}  // namespace
+
+	module_mapper::module_mapper(fs::path const& binary_dir,
+	                             fs::path const& repo,
+	                             bool build_missing)
+	    : binary_dir_{binary_dir}
+	    , repo_{repo}
+	    , build_missing_{build_missing} {}
+
+	std::vector<std::string> module_mapper::answer(
+	    std::vector<std::string> const& requests) {
+		std::vector<std::string> result{};
+		result.reserve(requests.size());
+		for (auto const& request : requests)
+			result.push_back(answer(request));
+		return result;
+	}
+
+	std::string module_mapper::answer(std::string_view request) {
+		auto const args = words(request);
+		if (args.empty()) return error("empty request"sv);
+
+		auto const& command = args.front();
+		if (command == "HELLO"sv) return "HELLO 1 c++modules"s;
+		if (command == "MODULE-REPO"sv)
+			return pathname(repo_.generic_u8string());
+		if (command == "MODULE-COMPILED"sv) return "OK"s;
+
+		if (args.size() < 2) return error(command + " needs an argument"s);
+		auto const name = as_u8sv(args[1]);
+		auto const bmi = interface_of(name);
+
+		if (command == "MODULE-EXPORT"sv) return pathname(bmi);
+		if (command == "MODULE-IMPORT"sv) {
+			if (available(bmi)) return pathname(bmi);
+			return error("no interface for "s + args[1]);
+		}
+		if (command == "INCLUDE-TRANSLATE"sv) {
+			// never built on demand, this is asked for every #include
+			std::error_code ec{};
+			if (fs::is_regular_file(repo_ / bmi, ec)) return pathname(bmi);
+			return "BOOL FALSE"s;
+		}
+		return error("unknown request "s + command);
+	}
+
+	std::u8string module_mapper::interface_of(std::u8string_view name) const {
+		std::u8string result{};
+		if (name.starts_with(u8'/')) {
+			// header unit, by its absolute path
+			result.assign(name.substr(1));
+		} else if (name.starts_with(u8"./"sv)) {
+			result.assign(u8",/"sv);
+			result.append(name.substr(2));
+		} else if (name.starts_with(u8"../"sv)) {
+			result.assign(u8",,/"sv);
+			result.append(name.substr(3));
+		} else {
+			result.assign(name);
+			std::replace(result.begin(), result.end(), u8':', u8'-');
+		}
+		result.append(u8".gcm"sv);
+		return result;
+	}
+
+	bool module_mapper::available(std::u8string const& bmi) {
+		auto const path = repo_ / bmi;
+		std::error_code ec{};
+		if (fs::is_regular_file(path, ec)) return true;
+		if (!build_missing_) return false;
+
+		// one build at a time; the one before may have built this one, too
+		std::lock_guard lock{build_lock_};
+		if (fs::is_regular_file(path, ec)) return true;
+
+		auto const ninja = env::which(u8"ninja"sv);
+		if (ninja.empty()) return false;
+		std::vector<std::string> const args{
+		    as_str(ninja.generic_u8string()),
+		    "-C"s,
+		    as_str(binary_dir_.generic_u8string()),
+		    as_str(path.lexically_relative(binary_dir_).generic_u8string()),
+		};
+		// stdout may be the connection to the compiler
+		auto const to_stderr = [](char const* bytes, size_t length) {
+			std::cerr.write(bytes, static_cast<std::streamsize>(length));
+		};
+		TinyProcessLib::Process build{args, "", to_stderr, to_stderr};
+		if (build.get_exit_status() != 0) return false;
+		return fs::is_regular_file(path, ec);
+	}
+
+	void module_mapper::serve(std::istream& in, std::ostream& out) {
+		block_reader reader{};
+		std::string line{};
+		while (std::getline(in, line)) {
+			if (!reader.add(std::move(line))) continue;
+			out << joined(answer(reader.block)) << std::flush;
+			reader.block.clear();
+		}
+	}
+
+	bool module_mapper::serve_socket(fs::path const& socket) {
+#ifdef _WIN32
+		std::cerr << "c++modules: error: cannot listen on "
+		          << as_sv(socket.generic_u8string())
+		          << ": not supported on this platform\n";
+		return false;
+#else
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		auto const name = socket.native();
+		if (name.size() >= sizeof(address.sun_path)) {
+			std::cerr << "c++modules: error: socket path too long: " << name
+			          << '\n';
+			return false;
+		}
+		std::copy(name.begin(), name.end(), address.sun_path);
+
+		auto const server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		std::error_code ec{};
+		fs::remove(socket, ec);
+		if (server < 0 ||
+		    ::bind(server, reinterpret_cast<sockaddr const*>(&address),
+		           sizeof(address)) != 0 ||
+		    ::listen(server, SOMAXCONN) != 0) {
+			std::cerr << "c++modules: error: cannot listen on " << name
+			          << '\n';
+			if (server >= 0) ::close(server);
+			return false;
+		}
+
+		while (true) {
+			auto const client = ::accept(server, nullptr, nullptr);
+			if (client < 0) break;
+			std::thread{serve_client, std::ref(*this), client}.detach();
+		}
+		::close(server);
+		std::cerr << "c++modules: error: cannot accept clients on " << name
+		          << '\n';
+		return false;
+#endif
+	}
+}  // namespace env
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <fs/file.hh>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace env {
+	// Server side of GCC's module mapper protocol (-fmodule-mapper=...).
+	// Interfaces are named the way GCC names them by itself, inside the
+	// `repo` dir; an import is only answered with an interface which is
+	// there. With `build_missing`, a missing interface is first built by
+	// running ninja in the binary dir, which needs the build.ninja of a
+	// previous run, and must not be done from inside that same ninja.
+	class module_mapper {
+	public:
+		module_mapper(fs::path const& binary_dir,
+		              fs::path const& repo,
+		              bool build_missing);
+
+		// One response for each request of a block.
+		std::vector<std::string> answer(
+		    std::vector<std::string> const& requests);
+
+		// Reads blocks of requests from `in`, until the client is gone;
+		// for -fmodule-mapper=|program.
+		void serve(std::istream& in, std::ostream& out);
+		// Serves every client connecting to a Unix-domain socket on its
+		// own thread; for -fmodule-mapper==socket. Returns on errors only.
+		bool serve_socket(fs::path const& socket);
+
+	private:
+		std::string answer(std::string_view request);
+		// interface for a module, or a header unit, relative to the repo
+		std::u8string interface_of(std::u8string_view name) const;
+		bool available(std::u8string const& bmi);
+
+		fs::path binary_dir_;
+		fs::path repo_;
+		bool build_missing_;
+		std::mutex build_lock_{};
+	};
+}  // namespace env
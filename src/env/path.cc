@@ -306,4 +306,24 @@ namespace env {
 #endif
 
 	fs::path which(fs::path const& tool) { return fullpath(tool); }
+
+	fs::path user_cache_dir() {
+		auto const from_var = [](char const* name) -> fs::path {
+			auto const value = std::getenv(name);
+			if (!value || !*value) return {};
+			return as_u8sv(value);
+		};
+
+#ifdef _WIN32
+		auto root = from_var("LOCALAPPDATA");
+#else
+		auto root = from_var("XDG_CACHE_HOME");
+		if (root.empty()) {
+			root = from_var("HOME");
+			if (!root.empty()) root /= u8".cache"sv;
+		}
+#endif
+		if (root.empty()) return {};
+		return root / u8"c++modules"sv;
+	}
 }  // namespace env
@@ -56,4 +56,9 @@ namespace env {
 	};
 
 	fs::path which(fs::path const& tool);
+
+	// Per-user directory for build results shared between build dirs:
+	// %LOCALAPPDATA%, $XDG_CACHE_HOME or ~/.cache, then c++modules. Empty,
+	// if none of the variables is set.
+	fs::path user_cache_dir();
 };  // namespace env
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "env/result_store.hh"
+#include <base/digest.hh>
+#include <base/utils.hh>
+#include <env/path.hh>
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <process.hpp>
+#include <random>
+
+using namespace std::literals;
+
+// Layout: <root>/<first two digits of the key>/<key>/<N>, where N is the
+// position of the output on the command line. An entry is filled in a
+// temporary dir next to it and renamed into place, so concurrent jobs
+// either see the whole entry or none at all. <root>/size has a line with
+// the size of each entry added since the last eviction, so the entries are
+// only walked once their sum grows over the size of the store.
+// <root>/stats has one byte per lookup: h(it), m(iss) or u(ncacheable).
+namespace env {
+	namespace {
+		constexpr auto magic = "c++modules:store:1"sv;
+
+		// Drops everything writing a file, so the compiler only prints the
+		// preprocessed source; the module mappers stay, as imported header
+		// units are needed to preprocess the importers.
+		std::vector<std::string> preprocessing(
+		    fs::path const& compiler,
+		    std::span<std::string const> command) {
+			std::vector<std::string> args{as_str(compiler.generic_u8string())};
+			for (size_t index = 1; index < command.size(); ++index) {
+				std::string_view const arg{command[index]};
+				if (arg == "-o"sv || arg == "-MF"sv || arg == "-MT"sv ||
+				    arg == "-MQ"sv) {
+					++index;
+					continue;
+				}
+				if (arg == "-Xclang"sv && index + 1 < command.size() &&
+				    command[index + 1].starts_with("-emit-"sv)) {
+					++index;
+					continue;
+				}
+				if (arg == "-c"sv || arg == "-MD"sv || arg == "-MMD"sv ||
+				    arg == "-fmodule-only"sv || arg == "--precompile"sv ||
+				    arg.starts_with("-fmodule-output"sv))
+					continue;
+				args.emplace_back(arg);
+			}
+			args.emplace_back("-E"sv);
+			args.emplace_back("-o-"sv);
+			return args;
+		}
+
+		std::optional<std::string> preprocessed(
+		    std::vector<std::string> const& args) {
+			std::string text{};
+			TinyProcessLib::Process preproc{
+			    args, "",
+			    [&](const char* bytes, size_t n) { text.append(bytes, n); },
+			    [](const char*, size_t) {}};
+			if (preproc.get_exit_status() != 0) return std::nullopt;
+			return text;
+		}
+
+		// GCC names the working directory in a linemarker of its own,
+		// among the ones heading the output, with a trailing "//".
+		void drop_working_directory(std::string& text) {
+			size_t pos = 0;
+			while (pos < text.size() && text[pos] == '#') {
+				auto const eol = text.find('\n', pos);
+				auto const end =
+				    eol == std::string::npos ? text.size() : eol + 1;
+				auto line = std::string_view{text}.substr(pos, end - pos);
+				while (!line.empty() &&
+				       (line.back() == '\n' || line.back() == '\r'))
+					line.remove_suffix(1);
+				if (line.ends_with("//\""sv)) {
+					text.erase(pos, end - pos);
+					return;
+				}
+				pos = end;
+			}
+		}
+
+		// Paths into the build dir, relative to it, so that build dirs
+		// anywhere get the same key.
+		std::string relative(std::string_view text, std::string_view dir) {
+			std::string result{};
+			result.reserve(text.size());
+			while (true) {
+				auto const pos = text.find(dir);
+				if (pos == std::string_view::npos) break;
+				result.append(text.substr(0, pos));
+				text.remove_prefix(pos + dir.size());
+			}
+			result.append(text);
+			return result;
+		}
+
+		// A module map or a response file is named by its path in the
+		// build dir; what matters is what it lists.
+		std::optional<std::string> listed_in(std::string_view arg) {
+			for (auto const prefix : {"-fmodule-mapper="sv, "@"sv}) {
+				if (!arg.starts_with(prefix)) continue;
+				fs::path const path{as_u8sv(arg.substr(prefix.size()))};
+				std::error_code ec{};
+				if (!fs::is_regular_file(path, ec)) return std::nullopt;
+				auto const contents = fs::fopen(path, "rb").read();
+				return std::string{contents.begin(), contents.end()};
+			}
+			return std::nullopt;
+		}
+
+		// Directories directly inside `dir`, skipping the ones removed
+		// by another job in the meantime.
+		std::vector<fs::directory_entry> subdirs(fs::path const& dir) {
+			std::vector<fs::directory_entry> result{};
+			std::error_code ec{};
+			fs::directory_iterator it{dir, ec};
+			for (; !ec && it != fs::directory_iterator{}; it.increment(ec)) {
+				std::error_code ignored{};
+				if (it->is_directory(ignored)) result.push_back(*it);
+			}
+			return result;
+		}
+	}  // namespace
+
+	result_store::result_store(fs::path root, std::uint64_t max_size)
+	    : root_{std::move(root)}, max_size_{max_size} {}
+
+	fs::path result_store::shared_root() {
+		auto root = user_cache_dir();
+		if (!root.empty()) root /= u8"bmi"sv;
+		return root;
+	}
+
+	fs::path result_store::local_root() {
+		return fs::path{u8"c++modules"sv} / u8"cc"sv;
+	}
+
+	std::optional<std::string> result_store::key_for(
+	    std::span<std::string const> command,
+	    std::span<fs::path const> imports) {
+		if (command.empty()) return std::nullopt;
+		auto const compiler = which(as_u8sv(command.front()));
+		auto const filename = compiler.filename();
+		if (filename == u8"cl.exe"sv || filename == u8"cl"sv)
+			return std::nullopt;
+
+		// a compiler upgraded in place is a different compiler
+		std::error_code ec{};
+		auto const size = fs::file_size(compiler, ec);
+		if (ec) return std::nullopt;
+		auto const mtime = fs::last_write_time(compiler, ec);
+		if (ec) return std::nullopt;
+
+		auto text = preprocessed(preprocessing(compiler, command));
+		if (!text) return std::nullopt;
+		drop_working_directory(*text);
+
+		auto binary_dir = as_str(fs::current_path(ec).generic_u8string());
+		if (ec) return std::nullopt;
+		binary_dir.push_back('/');
+
+		digest key{};
+		key.update(magic);
+		key.update("\0"sv);
+		key.update(compiler.generic_u8string());
+		key.update("\0"sv);
+		key.update(std::to_string(size));
+		key.update("\0"sv);
+		key.update(std::to_string(mtime.time_since_epoch().count()));
+		for (auto const& arg : command.subspan(1)) {
+			key.update("\0"sv);
+			auto const listed = listed_in(arg);
+			if (listed) {
+				key.update(arg.front() == '@' ? "@"sv : "-fmodule-mapper="sv);
+				key.update(relative(*listed, binary_dir));
+			} else {
+				key.update(relative(arg, binary_dir));
+			}
+		}
+		key.update("\0\0"sv);
+		key.update(*text);
+		for (auto const& bmi : imports) {
+			auto const contents = fs::fopen(bmi, "rb").read();
+			key.update("\0"sv);
+			key.update(bmi.generic_u8string());
+			key.update("\0"sv);
+			key.update({contents.data(), contents.size()});
+		}
+		return key.hex();
+	}
+
+	fs::path result_store::entry(std::string_view key) const {
+		return root_ / as_u8sv(key.substr(0, 2)) / as_u8sv(key);
+	}
+
+	bool result_store::fetch(std::string_view key,
+	                      std::span<fs::path const> outputs) {
+		auto const dir = entry(key);
+		std::error_code ec{};
+		if (!fs::is_directory(dir, ec)) return false;
+
+		for (size_t index = 0; index < outputs.size(); ++index) {
+			auto const& output = outputs[index];
+			if (output.has_parent_path())
+				fs::create_directories(output.parent_path(), ec);
+			fs::copy_file(dir / std::to_string(index), output,
+			              fs::copy_options::overwrite_existing, ec);
+			if (ec) return false;
+		}
+
+		// the time of the entry's dir orders the eviction
+		fs::last_write_time(dir, fs::file_time_type::clock::now(), ec);
+		return true;
+	}
+
+	bool result_store::store(std::string_view key,
+	                      std::span<fs::path const> outputs) {
+		auto const dir = entry(key);
+		std::error_code ec{};
+		if (fs::is_directory(dir, ec)) return true;
+
+		auto temp = dir;
+		temp += u8".tmp-"sv;
+		temp += std::to_string(std::random_device{}());
+		fs::create_directories(temp, ec);
+		if (ec) return false;
+
+		std::uint64_t size{};
+		for (size_t index = 0; index < outputs.size(); ++index) {
+			auto const copy = temp / std::to_string(index);
+			fs::copy_file(outputs[index], copy, ec);
+			if (!ec) size += fs::file_size(copy, ec);
+			if (ec) {
+				fs::remove_all(temp, ec);
+				return false;
+			}
+		}
+
+		// losing the race to another job is fine, it stored the same files
+		fs::rename(temp, dir, ec);
+		if (ec) {
+			fs::remove_all(temp, ec);
+			return true;
+		}
+
+		log_size(size);
+		if (logged_size() > max_size_) evict();
+		return true;
+	}
+
+	int result_store::run(std::vector<std::string> command,
+	                      std::span<fs::path const> outputs,
+	                      std::span<fs::path const> imports,
+	                      lookup* how) {
+		auto const key =
+		    root_.empty() ? std::nullopt : key_for(command, imports);
+		auto const result = !key                   ? lookup::uncacheable
+		                    : fetch(*key, outputs) ? lookup::hit
+		                                           : lookup::miss;
+		if (how) *how = result;
+		if (result == lookup::hit) return 0;
+
+		command.front() =
+		    as_str(which(as_u8sv(command.front())).generic_u8string());
+		TinyProcessLib::Process compile{
+		    command, "",
+		    [](const char* bytes, size_t n) {
+			    std::cout.write(bytes, static_cast<std::streamsize>(n));
+		    },
+		    [](const char* bytes, size_t n) {
+			    std::cerr.write(bytes, static_cast<std::streamsize>(n));
+		    }};
+		auto const status = compile.get_exit_status();
+		if (status == 0 && key) store(*key, outputs);
+		return status;
+	}
+
+	void result_store::count(lookup how) const {
+		std::error_code ec{};
+		fs::create_directories(root_, ec);
+		auto const byte = how == lookup::hit    ? 'h'
+		                  : how == lookup::miss ? 'm'
+		                                        : 'u';
+		// "a" is O_APPEND, a single byte cannot be torn
+		auto file = fs::fopen(root_ / u8"stats"sv, "ab");
+		if (file) file.store(&byte, 1);
+	}
+
+	result_store::statistics result_store::stats() const {
+		statistics result{};
+		for (auto const byte : fs::fopen(root_ / u8"stats"sv, "rb").read()) {
+			switch (byte) {
+				case 'h':
+					++result.hits;
+					break;
+				case 'm':
+					++result.misses;
+					break;
+				case 'u':
+					++result.uncacheable;
+					break;
+				default:
+					break;
+			}
+		}
+		return result;
+	}
+
+	std::uint64_t result_store::logged_size() const {
+		std::uint64_t total{};
+		auto const log = fs::fopen(root_ / u8"size"sv, "rb").read();
+		std::string_view text{log.data(), log.size()};
+		while (!text.empty()) {
+			auto const eol = text.find('\n');
+			auto const line = text.substr(0, eol);
+			std::uint64_t size{};
+			auto const ret =
+			    std::from_chars(line.data(), line.data() + line.size(), size);
+			if (ret.ec == std::errc{}) total += size;
+			if (eol == std::string_view::npos) break;
+			text.remove_prefix(eol + 1);
+		}
+		return total;
+	}
+
+	void result_store::log_size(std::uint64_t size) const {
+		auto const line = std::to_string(size) + '\n';
+		// "a" is O_APPEND, a line this short is written at once
+		auto file = fs::fopen(root_ / u8"size"sv, "ab");
+		if (file) file.print(line);
+	}
+
+	void result_store::evict() {
+		struct item {
+			fs::path dir{};
+			fs::file_time_type used{};
+			std::uint64_t size{};
+		};
+
+		std::vector<item> items{};
+		std::uint64_t total{};
+		for (auto const& shard : subdirs(root_)) {
+			for (auto const& dir : subdirs(shard.path())) {
+				// entries still being filled in
+				if (dir.path().filename().native().find('.') !=
+				    fs::path::string_type::npos)
+					continue;
+
+				std::error_code ec{};
+				item current{dir.path(), dir.last_write_time(ec), 0};
+				fs::directory_iterator it{dir.path(), ec};
+				for (; !ec && it != fs::directory_iterator{};
+				     it.increment(ec)) {
+					std::error_code ignored{};
+					auto const size = it->file_size(ignored);
+					if (!ignored) current.size += size;
+				}
+				total += current.size;
+				items.push_back(std::move(current));
+			}
+		}
+
+		// down to 90%, so that the next few entries do not walk the store
+		// all over again
+		auto const target = max_size_ - max_size_ / 10;
+		if (total > max_size_) {
+			std::sort(items.begin(), items.end(),
+			          [](item const& lhs, item const& rhs) {
+				          return lhs.used < rhs.used;
+			          });
+			for (auto const& current : items) {
+				if (total <= target) break;
+				std::error_code ec{};
+				fs::remove_all(current.dir, ec);
+				if (!ec) total -= current.size;
+			}
+		}
+
+		// the walk gave the real size; sizes logged by other jobs in the
+		// meantime are lost, until the next walk counts them again
+		auto temp = root_ / u8"size.tmp-"sv;
+		temp += std::to_string(std::random_device{}());
+		auto const line = std::to_string(total) + '\n';
+		bool written{false};
+		if (auto file = fs::fopen(temp, "wb"); file)
+			written = file.print(line) == line.size();
+		std::error_code ec{};
+		if (written) fs::rename(temp, root_ / u8"size"sv, ec);
+		if (!written || ec) fs::remove(temp, ec);
+	}
+}  // namespace env
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <fs/file.hh>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace env {
+	// Content-addressed store of the files written by compiler commands
+	// (objects, BMIs and the depfile), under a key made of the compiler,
+	// the command line, the preprocessed source and the imported BMIs.
+	// Entries are copied, not linked: a shared inode would also share the
+	// timestamps the BMI firewall relies on. Least recently used entries
+	// go first, once the store grows over its size.
+	class result_store {
+	public:
+		static constexpr std::uint64_t default_size = 2048ull << 20;
+
+		enum class lookup { hit, miss, uncacheable };
+
+		struct statistics {
+			std::uint64_t hits{};
+			std::uint64_t misses{};
+			std::uint64_t uncacheable{};
+		};
+
+		explicit result_store(fs::path root,
+		                      std::uint64_t max_size = default_size);
+
+		// user_cache_dir()/bmi, shared by all build dirs; or empty
+		static fs::path shared_root();
+		// c++modules/cc, relative to the binary dir ninja runs in
+		static fs::path local_root();
+
+		// Empty, if the command cannot be preprocessed by itself (MSVC, or
+		// the preprocessor fails); such commands are not stored.
+		static std::optional<std::string> key_for(
+		    std::span<std::string const> command,
+		    std::span<fs::path const> imports);
+
+		// Copies the entry over the outputs; false, if there is none.
+		bool fetch(std::string_view key, std::span<fs::path const> outputs);
+		// Adds the outputs as a new entry, then trims the store, if it
+		// grew over its size.
+		bool store(std::string_view key, std::span<fs::path const> outputs);
+
+		// Runs the command, unless the store has the outputs for it, and
+		// stores them afterwards. Gives the exit status of the command.
+		int run(std::vector<std::string> command,
+		        std::span<fs::path const> outputs,
+		        std::span<fs::path const> imports,
+		        lookup* how = nullptr);
+
+		// Every lookup is a single byte appended to <root>/stats, which
+		// stays correct with any number of jobs writing at once.
+		void count(lookup how) const;
+		statistics stats() const;
+
+	private:
+		fs::path entry(std::string_view key) const;
+		// sum of the sizes logged in <root>/size
+		std::uint64_t logged_size() const;
+		void log_size(std::uint64_t size) const;
+		void evict();
+
+		fs::path root_;
+		std::uint64_t max_size_;
+	};
+}  // namespace env
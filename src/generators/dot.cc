@@ -19,6 +19,7 @@ namespace {
 						    return {};
 					    case rule_type::EMIT_BMI:
 					    case rule_type::EMIT_INCLUDE:
+					    case rule_type::COPY_BMI:
 						    return "hexagon"sv;
 					    case rule_type::ARCHIVE:
 						    return "septagon"sv;
@@ -53,6 +54,7 @@ namespace {
 					    case rule_type::COMPILE:
 					    case rule_type::EMIT_BMI:
 					    case rule_type::EMIT_INCLUDE:
+					    case rule_type::COPY_BMI:
 					    case rule_type::ARCHIVE:
 					    case rule_type::LINK_SO:
 					    case rule_type::LINK_MOD:
@@ -114,6 +116,42 @@ void dot::generate(std::filesystem::path const&,
 		nodeIds[target.main_output] = std::move(nodeId);
 	}
 
+	// side-effect BMIs are not nodes on their own; point at the target
+	// producing them
+	auto const find_node = [&](artifact const& in) {
+		auto dstNode = nodeIds.find(in);
+		if (dstNode != nodeIds.end()) return dstNode;
+		for (auto const& other : targets_) {
+			bool found = other.main_output == in;
+			if (!found) {
+				for (auto const& out : other.outputs.impl) {
+					if (out == in) {
+						found = true;
+						break;
+					}
+				}
+			}
+			if (!found) {
+				for (auto const& out : other.outputs.order) {
+					if (out == in) {
+						found = true;
+						break;
+					}
+				}
+			}
+			if (!found) {
+				for (auto const& out : other.outputs.expl) {
+					if (out == in) {
+						found = true;
+						break;
+					}
+				}
+			}
+			if (found) return nodeIds.find(other.main_output);
+		}
+		return nodeIds.end();
+	};
+
 	for (auto const& target : targets_) {
 		if (ignorable(target.rule)) continue;
 		auto srcNode = nodeIds.find(target.main_output);
@@ -133,7 +171,7 @@ void dot::generate(std::filesystem::path const&,
 
 		for (auto const& in : target.inputs.impl) {
 			if (ignored.count(in) != 0) continue;
-			auto dstNode = nodeIds.find(in);
+			auto dstNode = find_node(in);
 			if (dstNode == nodeIds.end()) continue;
 			if (first) {
 				first = false;
@@ -156,40 +194,7 @@ void dot::generate(std::filesystem::path const&,
 
 			std::string_view name{};
 
-			auto dstNode = nodeIds.find(in);
-			if (dstNode == nodeIds.end()) {
-				for (auto const& other : targets_) {
-					bool found = other.main_output == in;
-					if (!found) {
-						for (auto const& out : other.outputs.impl) {
-							if (out == in) {
-								found = true;
-								break;
-							}
-						}
-					}
-					if (!found) {
-						for (auto const& out : other.outputs.order) {
-							if (out == in) {
-								found = true;
-								break;
-							}
-						}
-					}
-					if (!found) {
-						for (auto const& out : other.outputs.expl) {
-							if (out == in) {
-								found = true;
-								break;
-							}
-						}
-					}
-					if (found) {
-						dstNode = nodeIds.find(other.main_output);
-						break;
-					}
-				}
-			}
+			auto dstNode = find_node(in);
 
 			if (dstNode != nodeIds.end()) {
 				name = dstNode->second;
@@ -0,0 +1,165 @@
+#include "generators/impact.hh"
+#include <base/build_graph.hh>
+#include <base/utils.hh>
+#include <generators/ninja.hh>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+using namespace std::literals;
+
+namespace {
+	std::string_view kind_of(target const& tgt) {
+		if (!std::holds_alternative<rule_type>(tgt.rule)) {
+			// the tool's own steps on the way to objects
+			if (tgt.rule == rule_name{"merge-units"s} ||
+			    tgt.rule == rule_name{"cc-batch"s})
+				return "obj"sv;
+			return {};
+		}
+		switch (std::get<rule_type>(tgt.rule)) {
+			case rule_type::MKDIR:
+				return {};
+			case rule_type::COMPILE:
+				return "obj"sv;
+			case rule_type::EMIT_BMI:
+			case rule_type::EMIT_INCLUDE:
+			case rule_type::COPY_BMI:
+				return "bmi"sv;
+			case rule_type::ARCHIVE:
+			case rule_type::LINK_SO:
+			case rule_type::LINK_MOD:
+			case rule_type::LINK_EXECUTABLE:
+				return "link"sv;
+		}
+		return {};
+	}
+
+	// marks everything reachable from the seeds, seeds included
+	std::vector<bool> downstream_of(build_graph const& graph,
+	                                std::vector<size_t> const& seeds) {
+		std::vector<bool> visited(graph.size());
+		std::vector<size_t> stack{seeds};
+		while (!stack.empty()) {
+			auto const id = stack.back();
+			stack.pop_back();
+			if (visited[id]) continue;
+			visited[id] = true;
+			for (auto consumer : graph.consumers[id])
+				if (!visited[consumer]) stack.push_back(consumer);
+		}
+		return visited;
+	}
+
+	std::vector<mod_name> modules_built_by(target const& tgt) {
+		std::vector<mod_name> result{};
+		auto const add = [&](artifact const& art) {
+			if (std::holds_alternative<mod_ref>(art))
+				result.push_back(std::get<mod_ref>(art).mod);
+		};
+		add(tgt.main_output);
+		for (auto const* list :
+		     {&tgt.outputs.expl, &tgt.outputs.impl, &tgt.outputs.order}) {
+			for (auto const& out : *list)
+				add(out);
+		}
+		return result;
+	}
+}  // namespace
+
+void impact::generate(std::filesystem::path const& back_to_sources,
+                      std::filesystem::path const&) {
+	auto const graph = build_graph::from(targets_);
+	auto const name_of = [&](target const& tgt) {
+		if (std::holds_alternative<mod_ref>(tgt.main_output))
+			return std::get<mod_ref>(tgt.main_output).path;
+		return filename_from(back_to_sources,
+		                     std::get<file_ref>(tgt.main_output), setups_);
+	};
+	auto const is_counted = [&](size_t id) {
+		return !kind_of(targets_[id]).empty();
+	};
+
+	size_t total{};
+	for (size_t id = 0; id < targets_.size(); ++id)
+		if (is_counted(id)) ++total;
+
+	if (!changed_.empty()) {
+		std::vector<size_t> seeds{};
+		for (auto const& changed : changed_) {
+			auto const filename = changed.lexically_normal().generic_u8string();
+			bool found = false;
+			// unity edges list their sources as implicit inputs
+			auto const reads = [&](artifact const& in) {
+				if (!std::holds_alternative<file_ref>(in)) return false;
+				auto const& file = std::get<file_ref>(in);
+				if (file.type != file_ref::input) return false;
+				auto const path =
+				    (std::filesystem::path{setups_[file.prj].subdir} /
+				     file.path)
+				        .lexically_normal()
+				        .generic_u8string();
+				return path == filename;
+			};
+			for (size_t id = 0; id < targets_.size(); ++id) {
+				auto const& inputs = targets_[id].inputs;
+				if (std::none_of(inputs.expl.begin(), inputs.expl.end(),
+				                 reads) &&
+				    std::none_of(inputs.impl.begin(), inputs.impl.end(),
+				                 reads))
+					continue;
+				seeds.push_back(id);
+				found = true;
+			}
+			if (!found) {
+				std::cerr << "c++modules: warning: " << as_sv(filename)
+				          << " is not a source of any target\n";
+			}
+		}
+
+		auto const rebuilt = downstream_of(graph, seeds);
+		auto const order = graph.topological_order();
+		size_t count{};
+		for (auto const id : order)
+			if (rebuilt[id] && is_counted(id)) ++count;
+
+		std::cout << "rebuilds " << count << " of " << total << " targets:\n";
+		for (auto const id : order) {
+			if (!rebuilt[id] || !is_counted(id)) continue;
+			std::cout << "  " << std::left << std::setw(5)
+			          << kind_of(targets_[id]) << as_sv(name_of(targets_[id]))
+			          << '\n';
+		}
+	}
+
+	struct fan_in {
+		mod_name name{};
+		size_t importers{};
+		size_t radius{};
+	};
+	std::vector<fan_in> ranking{};
+	for (size_t id = 0; id < targets_.size(); ++id) {
+		for (auto const& mod : modules_built_by(targets_[id])) {
+			auto const rebuilt = downstream_of(graph, {id});
+			size_t radius{};
+			for (size_t other = 0; other < rebuilt.size(); ++other)
+				if (rebuilt[other] && is_counted(other)) ++radius;
+			ranking.push_back({mod, graph.consumers[id].size(), radius});
+		}
+	}
+	std::stable_sort(ranking.begin(), ranking.end(),
+	                 [](fan_in const& lhs, fan_in const& rhs) {
+		                 return lhs.radius > rhs.radius;
+	                 });
+	if (ranking_ && ranking.size() > ranking_) ranking.resize(ranking_);
+
+	if (ranking.empty()) return;
+	if (!changed_.empty()) std::cout << '\n';
+	std::cout << "module fan-in (targets rebuilt / direct dependents):\n";
+	for (auto const& mod : ranking) {
+		std::cout << std::right << std::setw(6) << mod.radius << " / "
+		          << std::left << std::setw(4) << mod.importers << ' '
+		          << as_sv(mod.name.toString()) << '\n';
+	}
+}
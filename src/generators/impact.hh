@@ -0,0 +1,24 @@
+#pragma once
+
+#include <base/generator.hh>
+
+// Not a build system: reports which targets rebuild after the given
+// sources change, and how far a change to each module interface reaches.
+class impact : public generator {
+public:
+	using generator::generator;
+	void generate(std::filesystem::path const&,
+	              std::filesystem::path const&) override;
+
+	// paths relative to the source dir
+	void set_changed(std::vector<std::filesystem::path> changed) {
+		changed_ = std::move(changed);
+	}
+
+	// number of modules listed in the fan-in ranking; 0 for all
+	void set_ranking_size(size_t count) noexcept { ranking_ = count; }
+
+private:
+	std::vector<std::filesystem::path> changed_;
+	size_t ranking_{};
+};
@@ -40,6 +40,7 @@ namespace {
 				return (path{setup.subdir} / file.path).generic_u8string();
 			case file_ref::include:
 			case file_ref::header_module:
+			case file_ref::external:
 				break;
 		}
 		return file.path;
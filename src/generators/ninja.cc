@@ -1,6 +1,12 @@
 #include "generators/ninja.hh"
+#include <base/build_graph.hh>
 #include <base/utils.hh>
+#include <charconv>
 #include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
 #include <set>
 
 using namespace std::literals;
@@ -26,6 +32,8 @@ namespace {
 				return "$CFLAGS"sv;
 			case var::CXXFLAGS:
 				return "$CXXFLAGS"sv;
+			case var::DEPFILE:
+				return "$out.d"sv;
 		}
 		return {};
 	}
@@ -49,6 +57,8 @@ namespace {
 						    return "bmi"sv;
 					    case rule_type::EMIT_INCLUDE:
 						    return "header-module"sv;
+					    case rule_type::COPY_BMI:
+						    return "copy-bmi"sv;
 					    case rule_type::ARCHIVE:
 						    return "ar"sv;
 					    case rule_type::LINK_SO:
@@ -75,6 +85,7 @@ namespace {
 					    case rule_type::COMPILE:
 					    case rule_type::EMIT_BMI:
 					    case rule_type::EMIT_INCLUDE:
+					    case rule_type::COPY_BMI:
 					    case rule_type::ARCHIVE:
 					    case rule_type::LINK_SO:
 					    case rule_type::LINK_MOD:
@@ -86,10 +97,270 @@ namespace {
 		    },
 		    name);
 	}
+
+	bool builds_interfaces_only(rule_name const& name) {
+		return name == rule_name{rule_type::EMIT_BMI} ||
+		       name == rule_name{rule_type::EMIT_INCLUDE} ||
+		       name == rule_name{rule_type::COPY_BMI};
+	}
+
+	// a copy has no source to fingerprint nor anything to compile
+	bool copies_interfaces(rule_name const& name) {
+		return name == rule_name{rule_type::COPY_BMI};
+	}
+
+	bool is_interface(artifact const& art) {
+		return std::holds_alternative<mod_ref>(art) ||
+		       std::get<file_ref>(art).type == file_ref::header_module;
+	}
+
+	std::vector<artifact> interfaces_built_by(target const& tgt) {
+		std::vector<artifact> result{};
+		auto const add = [&](artifact const& art) {
+			if (is_interface(art)) result.push_back(art);
+		};
+		add(tgt.main_output);
+		for (auto const* list :
+		     {&tgt.outputs.expl, &tgt.outputs.impl, &tgt.outputs.order}) {
+			for (auto const& out : *list)
+				add(out);
+		}
+		return result;
+	}
+
+	struct logged_time {
+		long long start{};
+		long long end{};
+		// no other output logged with the same times, so not written by
+		// an edge building more than this file
+		bool alone{true};
+
+		double cost() const noexcept {
+			return static_cast<double>(end - start);
+		}
+	};
+
+	// Build times from the previous run, keyed by output path, in ms. Every
+	// output of a multi-output edge is logged with the same times.
+	std::map<std::u8string, logged_time> read_ninja_log(
+	    std::filesystem::path const& binary_dir) {
+		std::map<std::u8string, logged_time> result{};
+
+		std::ifstream log{binary_dir / u8".ninja_log"sv};
+		std::string line{};
+		if (!std::getline(log, line) || !line.starts_with("# ninja log v"sv))
+			return result;
+
+		while (std::getline(log, line)) {
+			// start <TAB> end <TAB> mtime <TAB> output <TAB> command hash
+			std::string_view fields[4]{};
+			std::string_view rest{line};
+			size_t index = 0;
+			for (; index < std::size(fields); ++index) {
+				auto const tab = rest.find('\t');
+				if (tab == std::string_view::npos) break;
+				fields[index] = rest.substr(0, tab);
+				rest = rest.substr(tab + 1);
+			}
+			if (index < std::size(fields)) continue;
+
+			long long start{}, end{};
+			auto const parse = [](std::string_view field, long long& value) {
+				auto const ret = std::from_chars(
+				    field.data(), field.data() + field.size(), value);
+				return ret.ec == std::errc{} &&
+				       ret.ptr == field.data() + field.size();
+			};
+			if (!parse(fields[0], start) || !parse(fields[1], end) ||
+			    end < start)
+				continue;
+
+			// later entries are from later builds
+			result[std::u8string{as_u8sv(fields[3])}] = {start, end};
+		}
+
+		std::map<std::pair<long long, long long>, size_t> outputs{};
+		for (auto const& [_, time] : result)
+			++outputs[{time.start, time.end}];
+		for (auto& [_, time] : result)
+			time.alone = outputs[{time.start, time.end}] == 1;
+
+		return result;
+	}
+
+	// Rough guess for targets missing from .ninja_log: compilations grow
+	// with the size of the source and the number of imported BMIs, links
+	// with the number of inputs. An interface-only edge stops after the
+	// front end, short of a compilation of the same source.
+	double estimate_cost(rule_name const& name,
+	                     std::uintmax_t source_size,
+	                     size_t imports,
+	                     size_t input_count) {
+		if (!std::holds_alternative<rule_type>(name)) return 0.0;
+		switch (std::get<rule_type>(name)) {
+			case rule_type::MKDIR:
+				return 0.0;
+			case rule_type::COPY_BMI:
+				return 10.0;
+			case rule_type::COMPILE:
+				return 100.0 + static_cast<double>(source_size) / 100.0 +
+				       20.0 * static_cast<double>(imports);
+			case rule_type::EMIT_BMI:
+			case rule_type::EMIT_INCLUDE:
+				return 0.6 * estimate_cost(rule_type::COMPILE, source_size,
+				                           imports, input_count);
+			case rule_type::ARCHIVE:
+			case rule_type::LINK_SO:
+			case rule_type::LINK_MOD:
+			case rule_type::LINK_EXECUTABLE:
+				return 50.0 + 5.0 * static_cast<double>(input_count);
+		}
+		return 0.0;
+	}
 }  // namespace
 
+std::vector<double> ninja::estimate_costs(
+    std::vector<target> const& targets,
+    std::filesystem::path const& back_to_sources,
+    std::filesystem::path const& binary_dir,
+    bool& from_log) const {
+	auto const history = read_ninja_log(binary_dir);
+	from_log = !history.empty();
+
+	std::vector<double> cost{};
+	cost.reserve(targets.size());
+	for (auto const& target : targets) {
+		if (name2sv(target.rule).empty()) {
+			cost.push_back(0.0);
+			continue;
+		}
+
+		// an interface logged with an object was built by a one-phase
+		// edge, which says little about an interface-only one
+		auto it = history.find(filename(back_to_sources, target.main_output));
+		if (it != history.end() &&
+		    (it->second.alone || !builds_interfaces_only(target.rule))) {
+			cost.push_back(it->second.cost());
+			continue;
+		}
+
+		std::uintmax_t source_size{};
+		size_t imports{};
+		for (auto const* list : {&target.inputs.impl, &target.inputs.order}) {
+			for (auto const& in : *list)
+				if (std::holds_alternative<mod_ref>(in)) ++imports;
+		}
+		for (auto const& in : target.inputs.expl) {
+			if (!std::holds_alternative<file_ref>(in) ||
+			    std::get<file_ref>(in).type != file_ref::input)
+				continue;
+			std::error_code ec{};
+			auto const size = std::filesystem::file_size(
+			    binary_dir / filename(back_to_sources, in), ec);
+			if (!ec) source_size += size;
+		}
+		cost.push_back(estimate_cost(target.rule, source_size, imports,
+		                             target.inputs.expl.size()));
+	}
+
+	return cost;
+}
+
+void ninja::pick_variant(std::filesystem::path const& back_to_sources,
+                         std::filesystem::path const& binary_dir) {
+	if (variants_.empty()) return;
+
+	auto const measure = [&](std::vector<target> const& targets) {
+		bool from_log{};
+		auto const graph = build_graph::from(targets);
+		auto const paths = critical_paths::from(
+		    graph,
+		    estimate_costs(targets, back_to_sources, binary_dir, from_log));
+		double longest{};
+		for (auto const length : paths.downstream)
+			longest = std::max(longest, length);
+		auto const total =
+		    std::accumulate(paths.cost.begin(), paths.cost.end(), 0.0);
+		return std::pair{longest, total};
+	};
+
+	auto best = measure(targets_);
+	for (auto& variant : variants_) {
+		auto const current = measure(variant);
+		if (current < best) {
+			best = current;
+			std::swap(targets_, variant);
+		}
+	}
+	variants_.clear();
+}
+
+// Ninja starts the edges ready at the same time roughly in the order they
+// appear in the manifest, so the targets heading the longest remaining
+// chains of work are written first.
+void ninja::order_by_critical_path(
+    std::filesystem::path const& back_to_sources,
+    std::filesystem::path const& binary_dir) {
+	bool from_log{};
+	auto cost =
+	    estimate_costs(targets_, back_to_sources, binary_dir, from_log);
+
+	auto const graph = build_graph::from(targets_);
+	auto const paths = critical_paths::from(graph, std::move(cost));
+
+	if (critical_paths_) {
+		std::cout << "c++modules: critical paths ("
+		          << (from_log ? "from .ninja_log"
+		                       : "estimated from source sizes")
+		          << ")\n";
+		size_t index = 0;
+		for (auto const& chain : paths.chains(graph, critical_paths_)) {
+			std::cout << std::setw(4) << ++index << ". " << std::fixed
+			          << std::setprecision(2)
+			          << paths.downstream[chain.front()] / 1000.0 << "s:";
+			bool first = true;
+			for (auto const id : chain) {
+				std::cout << (first ? " " : " -> ")
+				          << as_sv(filename(back_to_sources,
+				                            targets_[id].main_output));
+				first = false;
+			}
+			std::cout << '\n';
+		}
+	}
+
+	std::vector<target> ordered{};
+	ordered.reserve(targets_.size());
+	for (auto const id : paths.order())
+		ordered.push_back(std::move(targets_[id]));
+	targets_ = std::move(ordered);
+}
+
+bool ninja::cached(rule_name const& name) const {
+	return compile_cache_ && !bmi_tool_.empty() &&
+	       (name == rule_name{rule_type::COMPILE} ||
+	        name == rule_name{rule_type::EMIT_BMI});
+}
+
 void ninja::generate(std::filesystem::path const& back_to_sources,
                      std::filesystem::path const& binary_dir) {
+	pick_variant(back_to_sources, binary_dir);
+
+	// only the edges kept need their files, e.g. their module maps
+	for (auto const& target : targets_) {
+		for (auto const& [path, contents] : target.files) {
+			auto const full = binary_dir / path;
+			std::error_code ec{};
+			std::filesystem::create_directories(full.parent_path(), ec);
+			std::ofstream file{full, std::ios::binary};
+			file << contents;
+			if (ec || !file) {
+				std::cerr << "c++modules: warning: cannot write "
+				          << as_sv(full.generic_u8string()) << '\n';
+			}
+		}
+	}
+
 	std::ofstream build_ninja{binary_dir / u8"build.ninja"sv};
 
 	auto visitor = [&](auto const& arg) {
@@ -106,21 +377,71 @@ void ninja::generate(std::filesystem::path const& back_to_sources,
 	               "CXXFLAGS = -std=c++20\n"
 	               "\n";
 
-	for (auto const& rule : rules_) {
-		auto const name = name2sv(rule.name);
-		if (name.empty()) continue;
+	// Rules producing nothing but module interfaces go through the
+	// firewall as they are; the others get a second, "-bmi" variant for
+	// the targets with interfaces among their outputs. Copies of shared
+	// interfaces are only compared with the old ones: a shared interface
+	// rebuilt by another build dir is newer, but not always different.
+	std::set<rule_name> runnable{};
+	if (!bmi_tool_.empty()) {
+		for (auto const& rule : rules_) {
+			if (!rule.commands.empty()) runnable.insert(rule.name);
+		}
+	}
 
+	std::set<rule_name> bmi_variants{};
+	for (auto const& target : targets_) {
+		if (runnable.count(target.rule) &&
+		    !builds_interfaces_only(target.rule) &&
+		    !interfaces_built_by(target).empty())
+			bmi_variants.insert(target.rule);
+	}
+
+	auto const write_rule = [&](rule const& rule, std::string_view name,
+	                            bool firewall) {
 		build_ninja << "rule " << name << '\n';
+		auto const copy = copies_interfaces(rule.name);
 
 		build_ninja << "    command = ";
-		bool first_command = true;
-		for (auto const& cmd : rule.commands) {
-			if (first_command)
-				first_command = false;
-			else
-				build_ninja << " && ";
-			for (auto const& arg : cmd)
-				std::visit(visitor, arg);
+		if (firewall)
+			build_ninja << as_sv(bmi_tool_) << " bmi-swap save $BMI && ";
+		// the store shared between build dirs goes first
+		if (firewall && !copy && bmi_store_ && rule.commands.size() == 1) {
+			build_ninja << as_sv(bmi_tool_) << " bmi-store --max-size "
+			            << bmi_store_
+			            << (rule.deps == dep_format::gcc ? " --depfile $out.d"sv
+			                                             : ""sv)
+			            << " $BMI --imports $BMI_IMPORTS -- ";
+		} else if (cached(rule.name) && rule.commands.size() == 1) {
+			build_ninja << as_sv(bmi_tool_) << " cc --max-size "
+			            << compile_cache_
+			            << (rule.deps == dep_format::gcc ? " --depfile $out.d"sv
+			                                             : ""sv)
+			            << " $out $BMI --imports $BMI_IMPORTS -- ";
+		}
+		auto const write_commands = [&](std::string_view separator) {
+			bool first_command = true;
+			for (auto const& cmd : rule.commands) {
+				if (first_command)
+					first_command = false;
+				else
+					build_ninja << separator;
+				for (auto const& arg : cmd)
+					std::visit(visitor, arg);
+			}
+		};
+		write_commands(" && "sv);
+		// the command goes into the fingerprint, so a new define or flag
+		// is never hidden behind an unchanged source
+		if (firewall && !copy && bmi_guard_) {
+			build_ninja << " && " << as_sv(bmi_tool_) << " bmi-guard $in $BMI"
+			            << (rule.deps == dep_format::gcc ? " --depfile $out.d"sv
+			                                             : ""sv)
+			            << " --imports $BMI_IMPORTS -- ";
+			write_commands(" "sv);
+		} else if (firewall) {
+			build_ninja << " && " << as_sv(bmi_tool_)
+			            << " bmi-swap restore $BMI";
 		}
 		build_ninja << '\n';
 
@@ -135,9 +456,35 @@ void ninja::generate(std::filesystem::path const& back_to_sources,
 			build_ninja << '\n';
 		}
 
+		switch (rule.deps) {
+			case dep_format::none:
+				break;
+			case dep_format::gcc:
+				build_ninja << "    depfile = $out.d\n    deps = gcc\n";
+				break;
+			case dep_format::msvc:
+				build_ninja << "    deps = msvc\n";
+				break;
+		}
+
+		if (firewall) build_ninja << "    restat = 1\n";
+
 		build_ninja << '\n';
+	};
+
+	for (auto const& rule : rules_) {
+		auto const name = name2sv(rule.name);
+		if (name.empty()) continue;
+
+		write_rule(rule, name,
+		           runnable.count(rule.name) &&
+		               builds_interfaces_only(rule.name));
+		if (bmi_variants.count(rule.name))
+			write_rule(rule, std::string{name} + "-bmi", true);
 	}
 
+	order_by_critical_path(back_to_sources, binary_dir);
+
 	std::set<artifact> ignored;
 	for (auto const& target : targets_) {
 		if (ignorable(target.rule)) {
@@ -166,7 +513,12 @@ void ninja::generate(std::filesystem::path const& back_to_sources,
 		for (auto const& out : target.outputs.order)
 			build_ninja << ' ' << as_sv(filename(back_to_sources, out));
 
+		auto const interfaces =
+		    bmi_tool_.empty() ? std::vector<artifact>{}
+		                      : interfaces_built_by(target);
 		build_ninja << ": " << name;
+		if (!interfaces.empty() && bmi_variants.count(target.rule))
+			build_ninja << "-bmi";
 
 		for (auto const& in : target.inputs.expl) {
 			if (ignored.count(in) != 0) continue;
@@ -191,6 +543,32 @@ void ninja::generate(std::filesystem::path const& back_to_sources,
 			build_ninja << ' ' << as_sv(filename(back_to_sources, in));
 		}
 		build_ninja << '\n';
+
+		for (auto const& [name, value] : target.vars)
+			build_ninja << "    " << name << " = " << as_sv(value) << '\n';
+
+		if (!interfaces.empty()) {
+			build_ninja << "    BMI =";
+			for (auto const& bmi : interfaces)
+				build_ninja << ' ' << as_sv(filename(back_to_sources, bmi));
+			build_ninja << '\n';
+		}
+
+		if ((!interfaces.empty() && !copies_interfaces(target.rule) &&
+		     (bmi_guard_ || bmi_store_)) ||
+		    cached(target.rule)) {
+			bool first_import = true;
+			for (auto const* list :
+			     {&target.inputs.impl, &target.inputs.order}) {
+				for (auto const& in : *list) {
+					if (!is_interface(in)) continue;
+					build_ninja << (first_import ? "    BMI_IMPORTS = " : " ")
+					            << as_sv(filename(back_to_sources, in));
+					first_import = false;
+				}
+			}
+			if (!first_import) build_ninja << '\n';
+		}
 	}
 }
 
@@ -213,13 +591,14 @@ std::u8string filename_from(std::filesystem::path const& back_to_sources,
 			return (path{setup.subdir} / file.path).generic_u8string();
 		case file_ref::include:
 		case file_ref::header_module:
+		case file_ref::external:
 			break;
 	}
 	return file.path;
 }
 
 std::u8string ninja::filename(std::filesystem::path const& back_to_sources,
-                              artifact const& fileref) {
+                              artifact const& fileref) const {
 	return std::visit(
 	    [&](auto const& file) -> std::u8string {
 		    if constexpr (std::is_same_v<decltype(file), file_ref const&>) {
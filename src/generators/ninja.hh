@@ -2,11 +2,63 @@
 
 #include <base/generator.hh>
 
+// Path of the file, as seen from the binary dir; also used by generators
+// reporting on the ninja build.
+std::u8string filename_from(std::filesystem::path const& back_to_sources,
+                            file_ref const& file,
+                            std::vector<project_setup> const& setups);
+
 class ninja : public generator {
 public:
 	void generate(std::filesystem::path const&,
 	              std::filesystem::path const&) override;
 
 	std::u8string filename(std::filesystem::path const& back_to_sources,
-	                       artifact const&);
+	                       artifact const&) const;
+
+	// number of critical chains to print after generating; 0 for none
+	void report_critical_paths(size_t count) noexcept {
+		critical_paths_ = count;
+	}
+
+	// c++modules itself, for the BMI firewall: rules building module
+	// interfaces keep the previous BMI, if the new one is identical, and
+	// declare restat; empty to turn the firewall off
+	void set_bmi_tool(std::u8string tool) { bmi_tool_ = std::move(tool); }
+	// with the guard on, a BMI is also kept when its source changed only
+	// in comments or whitespace; it then points to outdated source lines
+	void use_bmi_guard(bool guard) noexcept { bmi_guard_ = guard; }
+	// rules building nothing but module interfaces fetch them from the
+	// shared BMI store, if they can; size in MiB, 0 for no store
+	void use_bmi_store(size_t max_size) noexcept { bmi_store_ = max_size; }
+	// compiles (COMPILE and EMIT_BMI) go through the compile cache of the
+	// binary dir; size in MiB, 0 for no cache
+	void use_compile_cache(size_t max_size) noexcept {
+		compile_cache_ = max_size;
+	}
+
+protected:
+	// time each target takes to build, in ms, from the previous build's
+	// .ninja_log or estimated
+	std::vector<double> estimate_costs(
+	    std::vector<target> const& targets,
+	    std::filesystem::path const& back_to_sources,
+	    std::filesystem::path const& binary_dir,
+	    bool& from_log) const;
+	// replaces the targets with the variant having the shortest critical
+	// path, if any; a tie goes to the one with less work in total
+	void pick_variant(std::filesystem::path const& back_to_sources,
+	                  std::filesystem::path const& binary_dir);
+
+private:
+	// COMPILE and EMIT_BMI, with the compile cache on
+	bool cached(rule_name const& name) const;
+	void order_by_critical_path(std::filesystem::path const& back_to_sources,
+	                            std::filesystem::path const& binary_dir);
+
+	size_t critical_paths_{};
+	std::u8string bmi_tool_{};
+	bool bmi_guard_{false};
+	size_t bmi_store_{};
+	size_t compile_cache_{};
 };
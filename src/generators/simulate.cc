@@ -0,0 +1,82 @@
+#include "generators/simulate.hh"
+#include <base/build_graph.hh>
+#include <base/utils.hh>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+using namespace std::literals;
+
+namespace {
+	constexpr size_t profile_rows = 10;
+	constexpr size_t profile_width = 50;
+
+	std::ostream& seconds(std::ostream& out, double ms) {
+		return out << std::fixed << std::setprecision(2) << ms / 1000.0 << 's';
+	}
+}  // namespace
+
+void simulate::generate(std::filesystem::path const& back_to_sources,
+                        std::filesystem::path const& binary_dir) {
+	pick_variant(back_to_sources, binary_dir);
+
+	bool from_log{};
+	auto cost =
+	    estimate_costs(targets_, back_to_sources, binary_dir, from_log);
+	auto const graph = build_graph::from(targets_);
+	auto const paths = critical_paths::from(graph, std::move(cost));
+
+	auto const total =
+	    std::accumulate(paths.cost.begin(), paths.cost.end(), 0.0);
+	double longest{};
+	for (auto const length : paths.downstream)
+		longest = std::max(longest, length);
+
+	std::cout << "costs " << (from_log ? "from .ninja_log" : "estimated")
+	          << "; total work ";
+	seconds(std::cout, total) << ", critical path ";
+	seconds(std::cout, longest) << '\n';
+
+	auto cores = cores_;
+	if (cores.empty()) cores.push_back(1);
+	for (auto const count : cores) {
+		auto const run = schedule::simulate(graph, paths, count);
+
+		std::cout << "\ncores: " << run.workers << "\n  wall time:   ";
+		seconds(std::cout, run.wall_time);
+		if (run.wall_time > 0)
+			std::cout << " (speedup " << std::setprecision(2)
+			          << total / run.wall_time << "x)";
+		auto const capacity = run.wall_time * static_cast<double>(run.workers);
+		auto const idle =
+		    capacity > 0 ? 100.0 * (1.0 - run.busy_time / capacity) : 0.0;
+		std::cout << "\n  idle cores:  " << std::setprecision(1) << idle
+		          << "%\n  parallelism:\n";
+
+		auto const profile = run.profile(profile_rows);
+		for (size_t row = 0; row < profile.size(); ++row) {
+			std::cout << "    " << std::right << std::setw(8);
+			seconds(std::cout, run.wall_time * static_cast<double>(row) /
+			                       static_cast<double>(profile.size()))
+			    << ' ' << std::setw(6) << std::setprecision(2) << profile[row]
+			    << " |";
+			auto const bar = static_cast<size_t>(
+			    profile[row] * static_cast<double>(profile_width) /
+			        static_cast<double>(run.workers) +
+			    0.5);
+			std::cout << std::string(bar, '#') << '\n';
+		}
+
+		std::cout << "  critical path:\n";
+		for (auto const id : run.critical_chain(graph)) {
+			if (!(paths.cost[id] > 0)) continue;
+			auto const& slot = run.slots[id];
+			std::cout << "    " << std::right << std::setw(8);
+			seconds(std::cout, slot.start) << " - " << std::setw(8);
+			seconds(std::cout, slot.finish)
+			    << "  "
+			    << as_sv(filename(back_to_sources, targets_[id].main_output))
+			    << '\n';
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <generators/ninja.hh>
+
+// Not a build system either: runs the ninja build on paper, for a number
+// of cores each, and reports the predicted wall time and how busy the
+// cores would be.
+class simulate : public ninja {
+public:
+	using ninja::ninja;
+	void generate(std::filesystem::path const&,
+	              std::filesystem::path const&) override;
+
+	void set_cores(std::vector<size_t> cores) { cores_ = std::move(cores); }
+
+private:
+	std::vector<size_t> cores_;
+};
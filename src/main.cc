@@ -1,43 +1,700 @@
 #include <base/compiler.hh>
+#include <base/digest.hh>
+#include <base/include_graph.hh>
 #include <base/logger.hh>
 #include <base/types.hh>
 #include <base/utils.hh>
 #include <base/xml.hh>
+#include <cxx/fingerprint.hh>
+#include <cxx/unit_merge.hh>
+#include <env/bmi_firewall.hh>
+#include <env/compile_batch.hh>
+#include <env/module_mapper.hh>
+#include <env/path.hh>
+#include <env/result_store.hh>
 #include <generators/dot.hh>
+#include <generators/impact.hh>
 #include <generators/msbuild.hh>
 #include <generators/ninja.hh>
+#include <generators/simulate.hh>
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
 #include <iostream>
+#include <thread>
 
 using namespace std::literals;
 
+// c++modules [--critical-paths[=N]] [--bmi-guard] [--header-units[=N]]
+//            [--bmi-phases=one|two|auto] [--unity[=N]] [--unity-budget=KiB]
+//            [--merge-units[=N]] [--batch-compile[=KiB]] [--bmi-store[=MiB]]
+//            [--compile-cache[=MiB]] [<source-dir>]
+// c++modules impact [-C <source-dir>] [--top N] [--header-units[=N]]
+//                   [--bmi-phases=one|two|auto] [--unity[=N]]
+//                   [--unity-budget=KiB] [--merge-units[=N]]
+//                   [--batch-compile[=KiB]] [<file>...]
+// c++modules simulate [-C <source-dir>] [--cores N[,N...]]
+//                     [--header-units[=N]] [--bmi-phases=one|two|auto]
+//                     [--unity[=N]] [--unity-budget=KiB] [--merge-units[=N]]
+//                     [--batch-compile[=KiB]]
+// c++modules includes [-C <source-dir>] [--top N] [--stale] [<header>...]
+// c++modules mapper [-C <source-dir>] [--socket <path>] [--build]
+// c++modules bmi-swap save|restore <bmi>...
+// c++modules bmi-guard <source> <bmi>... [--depfile <file>]
+//                      [--imports <bmi>...] [-- <command>...]
+// c++modules bmi-store [--max-size MiB] [--depfile <file>] <bmi>...
+//                      [--imports <bmi>...] -- <command>...
+// c++modules cc [--max-size MiB] [--depfile <file>] <output>...
+//               [--imports <bmi>...] -- <command>...
+// c++modules cc --stats
+// c++modules merge-units <output> <source>...
+// c++modules cc-batch --depfile <file> <source>... --objects <object>...
+//                     -- <command>...
+struct options {
+	enum command { generate, impact, simulate, includes, mapper };
+
+	command cmd{generate};
+	std::u8string self{};
+	char const* source_dir{nullptr};
+	size_t critical_paths{0};
+	bool bmi_guard{false};
+	size_t bmi_store{0};
+	size_t compile_cache{0};
+	size_t header_units{0};
+	size_t unity{0};
+	size_t unity_budget{0};
+	size_t merge_units{0};
+	size_t batch_compile{0};
+	compiler::bmi_phases bmi_phases{compiler::bmi_phases::automatic};
+	size_t top{0};
+	bool stale{false};
+	char const* socket{nullptr};
+	bool build_missing{false};
+	std::vector<std::filesystem::path> files{};
+	std::vector<size_t> cores{};
+};
+
+// The same project, whatever is done with it afterwards.
+void configure(compiler& cxx, options const& opts) {
+	cxx.promote_headers(opts.header_units);
+	cxx.set_bmi_phases(opts.bmi_phases);
+	cxx.set_unity(opts.unity, std::uint64_t{opts.unity_budget} << 10);
+	cxx.set_tool(opts.self);
+	cxx.merge_module_units(opts.merge_units);
+	cxx.batch_compiles(std::uint64_t{opts.batch_compile} << 10);
+}
+
 template <typename PlatformGenerator>
-void generate(compiler_info const& comp, build_info const& build) {
+void generate(compiler_info const& comp,
+              build_info const& build,
+              options const& opts) {
 	logger log{build, comp};
 	log.print();
 
 	PlatformGenerator gen{};
-	if (auto cxx = comp.create(log); cxx) cxx->mapout(build, gen);
+	if constexpr (std::is_same_v<PlatformGenerator, ninja>) {
+		gen.report_critical_paths(opts.critical_paths);
+		gen.set_bmi_tool(opts.self);
+		gen.use_bmi_guard(opts.bmi_guard);
+		gen.use_bmi_store(opts.bmi_store);
+		gen.use_compile_cache(opts.compile_cache);
+	}
+	if (auto cxx = comp.create(log); cxx) {
+		configure(*cxx, opts);
+		cxx->mapout(build, gen);
+	}
 
 	auto back_to_sources = build.source_from_binary();
 	gen.generate(back_to_sources, build.binary_dir);
 	std::move(gen).template to<dot>().generate(back_to_sources, build.binary_dir);
 }
 
+void report_impact(compiler_info const& comp,
+                   build_info const& build,
+                   options const& opts) {
+	logger log{build, comp};
+	log.print();
+
+	impact gen{};
+	gen.set_changed(opts.files);
+	gen.set_ranking_size(opts.top);
+	if (auto cxx = comp.create(log); cxx) {
+		configure(*cxx, opts);
+		cxx->mapout(build, gen);
+	}
+
+	gen.generate(build.source_from_binary(), build.binary_dir);
+}
+
+void simulate_build(compiler_info const& comp,
+                    build_info const& build,
+                    options const& opts) {
+	logger log{build, comp};
+	log.print();
+
+	simulate gen{};
+	auto cores = opts.cores;
+	if (cores.empty()) {
+		// 1, 2, 4... up to this machine
+		auto const here = std::max(std::thread::hardware_concurrency(), 1u);
+		for (size_t count = 1; count < here; count *= 2)
+			cores.push_back(count);
+		cores.push_back(here);
+	}
+	gen.set_cores(std::move(cores));
+	if (auto cxx = comp.create(log); cxx) {
+		configure(*cxx, opts);
+		cxx->mapout(build, gen);
+	}
+
+	gen.generate(build.source_from_binary(), build.binary_dir);
+}
+
+// Reads the include trees stored by the last run, so it needs neither the
+// compiler nor the preprocessor.
+int report_includes(options const& opts,
+                    std::filesystem::path const& source_dir,
+                    std::filesystem::path const& binary_dir) {
+	auto const db = include_graph::location(binary_dir);
+	auto const graph = include_graph::load(db);
+	if (graph.units.empty()) {
+		std::cerr << "c++modules: error: no include trees in "
+		          << as_sv(db.generic_u8string())
+		          << "; run c++modules first\n";
+		return 1;
+	}
+
+	auto const name_of = [&](std::uint32_t file) {
+		auto const& path = graph.files[file].path;
+		auto relative = fs::path{path}.lexically_relative(source_dir);
+		if (relative.empty() || *relative.begin() == u8".."sv) return path;
+		return relative.generic_u8string();
+	};
+	auto const unit_name = [&](std::uint32_t unit) {
+		return name_of(graph.units[unit].front().file);
+	};
+
+	auto sep = ""sv;
+	for (auto const& header : opts.files) {
+		std::cout << sep;
+		sep = "\n"sv;
+
+		// a full path names one file, anything else is matched against
+		// the ends of the recorded paths: "vector", "fmt/format.h"
+		std::vector<std::uint32_t> matches{};
+		auto const full =
+		    fs::absolute(header).lexically_normal().generic_u8string();
+		if (auto const id = graph.find(full); id) {
+			matches.push_back(*id);
+		} else {
+			auto const suffix = u8"/"s + header.generic_u8string();
+			for (std::uint32_t id = 0; id < graph.files.size(); ++id)
+				if (graph.files[id].path.ends_with(suffix))
+					matches.push_back(id);
+		}
+
+		if (matches.empty()) {
+			std::cerr << "c++modules: warning: "
+			          << as_sv(header.generic_u8string())
+			          << " is not included anywhere\n";
+			continue;
+		}
+
+		for (auto const id : matches) {
+			auto const units = graph.included_by(id);
+			std::cout << as_sv(name_of(id)) << ": included by "
+			          << units.size() << " of " << graph.units.size()
+			          << " translation units\n";
+			for (auto const& unit : units)
+				std::cout << "  " << std::right << std::setw(3) << unit.depth
+				          << ' ' << as_sv(unit_name(unit.unit)) << '\n';
+		}
+	}
+
+	if (opts.stale) {
+		std::cout << sep;
+		sep = "\n"sv;
+		auto const stale = graph.stale();
+		std::cout << stale.size() << " of " << graph.units.size()
+		          << " translation units need a rescan:\n";
+		for (auto const unit : stale)
+			std::cout << "  " << as_sv(unit_name(unit)) << '\n';
+	}
+
+	if (!opts.files.empty() || opts.stale) return 0;
+
+	auto ranking = graph.heaviest();
+	auto const top = opts.top ? opts.top : size_t{20};
+	if (ranking.size() > top) ranking.resize(top);
+	std::cout << "headers by preprocessed bytes (bytes / translation units):\n";
+	for (auto const& item : ranking) {
+		std::cout << std::right << std::setw(12) << item.bytes << " / "
+		          << std::left << std::setw(4) << item.units << ' '
+		          << as_sv(name_of(item.file)) << '\n';
+	}
+	return 0;
+}
+
+// Answers GCC's module mapper requests, with the interfaces from the
+// gcm.cache of the binary dir. Without a socket, the requests are read
+// from stdin, as in -fmodule-mapper='|c++modules mapper'.
+int serve_mapper(options const& opts, fs::path const& binary_dir) {
+	// GCC writes the interfaces it exports into the repository, but does
+	// not create it on its own
+	auto const repo = binary_dir / u8"gcm.cache"sv;
+	std::error_code ec{};
+	fs::create_directories(repo, ec);
+	if (ec) {
+		std::cerr << "c++modules: cannot create "
+		          << as_sv(repo.generic_u8string()) << ": " << ec.message()
+		          << '\n';
+		return 1;
+	}
+
+	env::module_mapper mapper{binary_dir, repo, opts.build_missing};
+	if (!opts.socket) {
+		mapper.serve(std::cin, std::cout);
+		return 0;
+	}
+	return mapper.serve_socket(fs::absolute(opts.socket)) ? 0 : 1;
+}
+
+bool parse_count(std::string_view arg, char const* origin, size_t& value) {
+	auto const ret = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+	if (ret.ec != std::errc{} || ret.ptr != arg.data() + arg.size()) {
+		std::cerr << "c++modules: error: expecting a number in " << origin
+		          << '\n';
+		return false;
+	}
+	return true;
+}
+
+constexpr unsigned used_by(options::command cmd) { return 1u << cmd; }
+constexpr unsigned mapping = used_by(options::generate) |
+                             used_by(options::impact) |
+                             used_by(options::simulate);
+
+// One line for each option: the commands taking it, how it gets its value
+// and what it does with it. A count is given as --name=N, or as a plain
+// --name, which stands for its preset, when it has one.
+struct option_spec {
+	enum form { flag, count, assigned, next };
+
+	std::string_view name{};
+	unsigned commands{};
+	form takes{flag};
+	size_t options::*target{};
+	size_t preset{};
+	bool (*apply)(options&, std::string_view, char const*){};
+};
+
+bool set_phases(options& opts, std::string_view value, char const* origin) {
+	if (value == "one"sv) {
+		opts.bmi_phases = compiler::bmi_phases::one;
+	} else if (value == "two"sv) {
+		opts.bmi_phases = compiler::bmi_phases::two;
+	} else if (value == "auto"sv) {
+		opts.bmi_phases = compiler::bmi_phases::automatic;
+	} else {
+		std::cerr << "c++modules: error: expecting one, two or auto in "
+		          << origin << '\n';
+		return false;
+	}
+	return true;
+}
+
+bool set_cores(options& opts, std::string_view list, char const* origin) {
+	while (!list.empty()) {
+		auto const comma = list.find(',');
+		auto& count = opts.cores.emplace_back();
+		if (!parse_count(list.substr(0, comma), origin, count)) return false;
+		if (comma == std::string_view::npos) break;
+		list.remove_prefix(comma + 1);
+	}
+	return true;
+}
+
+constexpr option_spec option_specs[] = {
+    {"--header-units"sv, mapping, option_spec::count, &options::header_units,
+     10},
+    {"--unity"sv, mapping, option_spec::count, &options::unity, 8},
+    {"--unity-budget"sv, mapping, option_spec::count, &options::unity_budget},
+    {"--merge-units"sv, mapping, option_spec::count, &options::merge_units, 4},
+    {"--batch-compile"sv, mapping, option_spec::count,
+     &options::batch_compile, 32},
+    {"--bmi-phases"sv, mapping, option_spec::assigned, {}, {}, set_phases},
+    {"--critical-paths"sv, used_by(options::generate), option_spec::count,
+     &options::critical_paths, 5},
+    {"--bmi-store"sv, used_by(options::generate), option_spec::count,
+     &options::bmi_store, env::result_store::default_size >> 20},
+    {"--compile-cache"sv, used_by(options::generate), option_spec::count,
+     &options::compile_cache, env::result_store::default_size >> 20},
+    {"--bmi-guard"sv, used_by(options::generate), option_spec::flag, {}, {},
+     [](options& opts, std::string_view, char const*) {
+	     opts.bmi_guard = true;
+	     return true;
+     }},
+    {"-C"sv, ~used_by(options::generate), option_spec::next, {}, {},
+     [](options& opts, std::string_view, char const* value) {
+	     opts.source_dir = value;
+	     return true;
+     }},
+    {"--top"sv, used_by(options::impact) | used_by(options::includes),
+     option_spec::next, {}, {},
+     [](options& opts, std::string_view value, char const* origin) {
+	     return parse_count(value, origin, opts.top);
+     }},
+    {"--cores"sv, used_by(options::simulate), option_spec::next, {}, {},
+     set_cores},
+    {"--stale"sv, used_by(options::includes), option_spec::flag, {}, {},
+     [](options& opts, std::string_view, char const*) {
+	     opts.stale = true;
+	     return true;
+     }},
+    {"--socket"sv, used_by(options::mapper), option_spec::next, {}, {},
+     [](options& opts, std::string_view, char const* value) {
+	     opts.socket = value;
+	     return true;
+     }},
+    {"--build"sv, used_by(options::mapper), option_spec::flag, {}, {},
+     [](options& opts, std::string_view, char const*) {
+	     opts.build_missing = true;
+	     return true;
+     }},
+};
+
+// 1 for an argument taken, 0 for one not known, -1 for a bad value
+int parse_option(int argc, char** argv, int& index, options& opts) {
+	std::string_view const arg{argv[index]};
+	auto const eq = arg.find('=');
+	auto const name = arg.substr(0, eq);
+	for (auto const& spec : option_specs) {
+		if (spec.name != name || !(spec.commands & used_by(opts.cmd)))
+			continue;
+
+		auto const assigned = eq != std::string_view::npos;
+		auto const value = assigned ? arg.substr(eq + 1) : ""sv;
+		switch (spec.takes) {
+			case option_spec::flag:
+				if (assigned) return 0;
+				return spec.apply(opts, value, argv[index]) ? 1 : -1;
+			case option_spec::count:
+				if (!assigned && !spec.preset) break;
+				if (!assigned) {
+					opts.*spec.target = spec.preset;
+					return 1;
+				}
+				return parse_count(value, argv[index], opts.*spec.target)
+				           ? 1
+				           : -1;
+			case option_spec::assigned:
+				if (!assigned) break;
+				return spec.apply(opts, value, argv[index]) ? 1 : -1;
+			case option_spec::next:
+				if (assigned || index + 1 == argc) break;
+				++index;
+				return spec.apply(opts, argv[index], argv[index]) ? 1 : -1;
+		}
+
+		std::cerr << "c++modules: error: " << name << " needs an argument\n";
+		return -1;
+	}
+	return 0;
+}
+
+bool parse_args(int argc, char** argv, options& opts) {
+	static constexpr std::pair<std::string_view, options::command>
+	    commands[] = {
+	        {"impact"sv, options::impact},
+	        {"simulate"sv, options::simulate},
+	        {"includes"sv, options::includes},
+	        {"mapper"sv, options::mapper},
+	    };
+
+	int index = 1;
+	for (auto const& [name, cmd] : commands) {
+		if (index < argc && argv[index] == name) {
+			opts.cmd = cmd;
+			++index;
+			break;
+		}
+	}
+
+	for (; index < argc; ++index) {
+		auto const taken = parse_option(argc, argv, index, opts);
+		if (taken < 0) return false;
+		if (taken) continue;
+
+		std::string_view const arg{argv[index]};
+		auto const positional = !arg.starts_with('-');
+		if (positional && opts.cmd == options::generate && !opts.source_dir) {
+			opts.source_dir = argv[index];
+		} else if (positional && (opts.cmd == options::impact ||
+		                          opts.cmd == options::includes)) {
+			opts.files.emplace_back(as_u8sv(arg));
+		} else {
+			std::cerr << "c++modules: error: unexpected argument " << arg
+			          << '\n';
+			return false;
+		}
+	}
+	return true;
+}
+
+// Called from inside the build, so it skips the compiler detection.
+int bmi_swap(int argc, char** argv) {
+	std::string_view const action{argc > 2 ? argv[2] : ""};
+	if (action != "save"sv && action != "restore"sv) {
+		std::cerr << "c++modules: error: expecting bmi-swap save|restore\n";
+		return 1;
+	}
+
+	std::vector<fs::path> bmis{};
+	for (int index = 3; index < argc; ++index)
+		bmis.emplace_back(as_u8sv(argv[index]));
+
+	auto const ok = action == "save"sv ? env::save_interfaces(bmis)
+	                                   : env::restore_interfaces(bmis);
+	return ok ? 0 : 1;
+}
+
+int bmi_guard(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "c++modules: error: expecting bmi-guard <source> "
+		             "<bmi>... [--depfile <file>] [--imports <bmi>...] "
+		             "[-- <command>...]\n";
+		return 1;
+	}
+
+	std::vector<fs::path> bmis{};
+	std::vector<fs::path> imports{};
+	auto* dest = &bmis;
+	int index = 3;
+	for (; index < argc; ++index) {
+		if (argv[index] == "--"sv) {
+			++index;
+			break;
+		}
+		if (argv[index] == "--imports"sv) {
+			dest = &imports;
+			continue;
+		}
+		if (argv[index] == "--depfile"sv && index + 1 < argc) {
+			// the source itself is covered by the fingerprint
+			fs::path const source{as_u8sv(argv[2])};
+			for (auto& header : env::read_depfile(as_u8sv(argv[++index]))) {
+				std::error_code ec{};
+				if (!fs::equivalent(header, source, ec))
+					imports.push_back(std::move(header));
+			}
+			continue;
+		}
+		dest->emplace_back(as_u8sv(argv[index]));
+	}
+
+	auto const source = fs::fopen(as_u8sv(argv[2]), "rb").read();
+	if (source.empty()) return env::restore_interfaces(bmis) ? 0 : 1;
+
+	// the same tokens compiled with other defines or flags make another
+	// interface
+	digest hash{};
+	hash.update(cxx::fingerprint({source.data(), source.size()}));
+	for (; index < argc; ++index) {
+		hash.update("\0"sv);
+		hash.update(std::string_view{argv[index]});
+	}
+	return env::guard_interfaces(hash.hex(), bmis, imports) ? 0 : 1;
+}
+
+// Called from inside the build, around a compiler command, which only
+// runs if the store has nothing for its inputs. bmi-store uses the store
+// shared by all build dirs, cc the one in the binary dir, and counts its
+// lookups.
+int launch(int argc, char** argv) {
+	auto const local = argv[1] == "cc"sv;
+	std::vector<fs::path> outputs{};
+	std::vector<fs::path> imports{};
+	std::optional<fs::path> depfile{};
+	size_t max_size = env::result_store::default_size >> 20;
+	bool stats = false;
+	auto* dest = &outputs;
+	int index = 2;
+	for (; index < argc; ++index) {
+		std::string_view const arg{argv[index]};
+		if (arg == "--"sv) {
+			++index;
+			break;
+		}
+		if (arg == "--imports"sv) {
+			dest = &imports;
+			continue;
+		}
+		if (arg == "--stats"sv && local) {
+			stats = true;
+			continue;
+		}
+		if (arg == "--depfile"sv && index + 1 < argc) {
+			depfile = as_u8sv(argv[++index]);
+			continue;
+		}
+		if (arg == "--max-size"sv && index + 1 < argc) {
+			++index;
+			if (!parse_count(argv[index], argv[index], max_size)) return 1;
+			continue;
+		}
+		dest->emplace_back(as_u8sv(arg));
+	}
+
+	env::result_store store{local ? env::result_store::local_root()
+	                              : env::result_store::shared_root(),
+	                        std::uint64_t{max_size} << 20};
+	if (stats) {
+		auto const [hits, misses, uncacheable] = store.stats();
+		auto const cacheable = hits + misses;
+		std::cout << hits << " hits, " << misses << " misses, " << uncacheable
+		          << " uncacheable\n";
+		if (cacheable) {
+			std::cout << "hit rate: " << std::fixed << std::setprecision(1)
+			          << 100.0 * static_cast<double>(hits) /
+			                 static_cast<double>(cacheable)
+			          << "%\n";
+		}
+		return 0;
+	}
+
+	std::vector<std::string> command{argv + index, argv + argc};
+	if (command.empty()) {
+		std::cerr << "c++modules: error: expecting " << argv[1]
+		          << " <output>... [--imports <bmi>...] -- <command>...\n";
+		return 1;
+	}
+
+	// $out and $BMI name the same file for a rule writing an interface
+	std::vector<fs::path> unique{};
+	for (auto& output : outputs) {
+		if (std::find(unique.begin(), unique.end(), output) == unique.end())
+			unique.push_back(std::move(output));
+	}
+	if (depfile) unique.push_back(*depfile);
+
+	env::result_store::lookup how{};
+	auto const status = store.run(std::move(command), unique, imports, &how);
+	if (local) store.count(how);
+	return status;
+}
+
+// Called from inside the build, for the units of a module compiled
+// together. The output keeps its time when the merged text is the same.
+int merge_units(int argc, char** argv) {
+	if (argc < 4) {
+		std::cerr << "c++modules: error: expecting merge-units <output> "
+		             "<source>...\n";
+		return 1;
+	}
+
+	std::vector<cxx::unit_source> units{};
+	for (int index = 3; index < argc; ++index) {
+		auto const text = fs::fopen(as_u8sv(argv[index]), "rb").read();
+		units.push_back({argv[index], {text.data(), text.size()}});
+	}
+
+	fs::path const output{as_u8sv(argv[2])};
+	auto const merged = cxx::merge_units(units);
+	if (!merged) {
+		std::cerr << "c++modules: error: cannot merge the sources of "
+		          << argv[2] << " any longer; run c++modules again\n";
+		return 1;
+	}
+
+	auto const current = fs::fopen(output, "rb").read();
+	if (std::string_view{current.data(), current.size()} == *merged)
+		return 0;
+
+	auto file = fs::fopen(output, "wb");
+	if (!file || file.store(merged->data(), merged->size()) != merged->size()) {
+		std::cerr << "c++modules: error: cannot write " << argv[2] << '\n';
+		return 1;
+	}
+	return 0;
+}
+
+// Called from inside the build, for the small sources compiled by one
+// compiler process.
+int compile_batch(int argc, char** argv) {
+	std::vector<fs::path> sources{};
+	std::vector<fs::path> objects{};
+	fs::path depfile{};
+	auto* dest = &sources;
+	int index = 2;
+	for (; index < argc; ++index) {
+		std::string_view const arg{argv[index]};
+		if (arg == "--"sv) {
+			++index;
+			break;
+		}
+		if (arg == "--objects"sv) {
+			dest = &objects;
+			continue;
+		}
+		if (arg == "--depfile"sv && index + 1 < argc) {
+			depfile = as_u8sv(argv[++index]);
+			continue;
+		}
+		dest->emplace_back(as_u8sv(arg));
+	}
+
+	std::vector<std::string> command{argv + index, argv + argc};
+	if (command.empty() || depfile.empty()) {
+		std::cerr << "c++modules: error: expecting cc-batch --depfile <file> "
+		             "<source>... --objects <object>... -- <command>...\n";
+		return 1;
+	}
+	return env::compile_batch(std::move(command), sources, objects, depfile);
+}
+
+// Path to this executable, as the build should call it.
+std::u8string self_path(char const* argv0) {
+	fs::path path{as_u8sv(argv0)};
+	if (!path.has_parent_path()) path = env::which(path);
+	if (!path.has_parent_path()) return {};
+	std::error_code ec{};
+	auto result = fs::absolute(path, ec);
+	if (ec) return {};
+	return result.lexically_normal().generic_u8string();
+}
+
 int main(int argc, char** argv) {
-	if (argc > 1) {
+	if (argc > 1 && argv[1] == "bmi-swap"sv) return bmi_swap(argc, argv);
+	if (argc > 1 && argv[1] == "bmi-guard"sv) return bmi_guard(argc, argv);
+	if (argc > 1 && (argv[1] == "bmi-store"sv || argv[1] == "cc"sv))
+		return launch(argc, argv);
+	if (argc > 1 && argv[1] == "merge-units"sv)
+		return merge_units(argc, argv);
+	if (argc > 1 && argv[1] == "cc-batch"sv)
+		return compile_batch(argc, argv);
+
+	options opts{};
+	if (!parse_args(argc, argv, opts)) return 1;
+	opts.self = self_path(argv[0]);
+
+	if (opts.source_dir) {
 		std::error_code ec{};
-		fs::current_path(argv[1], ec);
+		fs::current_path(opts.source_dir, ec);
 		if (ec) {
-			std::cerr << "c++modules: cannot change directory to " << argv[1]
-			          << ": " << ec.message() << '\n';
+			std::cerr << "c++modules: cannot change directory to "
+			          << opts.source_dir << ": " << ec.message() << '\n';
 			return 1;
 		}
 	}
 
-	load_xml_compilers();
-
 	auto source_dir = fs::current_path();
 	auto binary_dir = source_dir / u8"build"sv;
+	if (opts.cmd == options::includes)
+		return report_includes(opts, source_dir, binary_dir);
+	if (opts.cmd == options::mapper)
+		return serve_mapper(opts, binary_dir);
+
+	load_xml_compilers();
 
 	std::error_code ec{};
 	fs::create_directories(binary_dir, ec);
@@ -51,9 +708,25 @@ int main(int argc, char** argv) {
 	auto const comp = compiler_info::from_environment(binary_dir);
 	auto const build = build_info::analyze(project::load(source_dir), comp,
 	                                       source_dir, binary_dir);
+	fs::create_directories(include_graph::location(binary_dir).parent_path(),
+	                       ec);
+	if (!build.includes.store(include_graph::location(binary_dir))) {
+		std::cerr << "c++modules: warning: cannot write "
+		          << as_sv(include_graph::location(binary_dir)
+		                       .generic_u8string())
+		          << '\n';
+	}
 
-	if (comp.cat == compiler_info::vc)
-		generate<msbuild>(comp, build);
-	else
-		generate<ninja>(comp, build);
+	if (opts.cmd == options::impact) {
+		for (auto& file : opts.files)
+			file = fs::absolute(file).lexically_normal().lexically_relative(
+			    source_dir);
+		report_impact(comp, build, opts);
+	} else if (opts.cmd == options::simulate) {
+		simulate_build(comp, build, opts);
+	} else if (comp.cat == compiler_info::vc) {
+		generate<msbuild>(comp, build, opts);
+	} else {
+		generate<ninja>(comp, build, opts);
+	}
 }
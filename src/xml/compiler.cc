@@ -1,18 +1,421 @@
 #include "xml/compiler.hh"
 #include <base/generator.hh>
 #include <base/utils.hh>
+#include <cxx/unit_merge.hh>
 #include <env/path.hh>
 #include <env/defaults.hh>
 #include "process.hpp"
 #include "types.hh"
+#include <algorithm>
+#include <set>
 
 using namespace std::literals;
 
 namespace xml {
+	namespace {
+		struct promoted_headers {
+			// translation unit -> header units replacing its #includes
+			std::map<std::u8string, std::vector<artifact>> by_source{};
+			// header unit -> header units included by its header
+			std::map<artifact, std::vector<artifact>> imports{};
+			// translation unit -> names its compiler looks the header
+			// units up by, with their BMIs, where they are not the paths
+			std::map<std::u8string, env::header_names> names{};
+		};
+
+		// Picks the headers, which would save the most of preprocessed
+		// text when compiled once. Only the headers from the source dir,
+		// included by more than one translation unit, are considered, and
+		// only for compilers turning an #include into an import.
+		promoted_headers promote(build_info const& build,
+		                         size_t count,
+		                         env::binary_interface& bin) {
+			promoted_headers result{};
+			if (!count || !bin.translates_includes()) return result;
+
+			auto const& graph = build.includes;
+			std::vector<bool> is_source(graph.files.size());
+			for (auto const& unit : graph.units)
+				is_source[unit.front().file] = true;
+
+			auto const root = build.source_dir + u8'/';
+			auto const binary = build.binary_dir + u8'/';
+			std::map<std::uint32_t, artifact> units{};
+			for (auto const& item : graph.heaviest(true)) {
+				if (units.size() == count) break;
+				auto const& path = graph.files[item.file].path;
+				if (item.units < 2 || is_source[item.file] ||
+				    !path.starts_with(root) || path.starts_with(binary))
+					continue;
+				auto const name =
+				    u8'"' + path.substr(root.size()) + u8'"';
+				units[item.file] = bin.header_unit(path, name);
+			}
+
+			for (auto const& unit : graph.units) {
+				auto const& source = graph.files[unit.front().file].path;
+				auto& deps = result.by_source[source];
+				auto const names = build.include_names.find(source);
+				for (size_t index = 0; index < unit.size(); ++index) {
+					auto it = units.find(unit[index].file);
+					if (it == units.end()) continue;
+					deps.push_back(it->second);
+
+					if (names != build.include_names.end()) {
+						auto const& path = graph.files[unit[index].file].path;
+						auto name = names->second.find(path);
+						if (name != names->second.end())
+							result.names[source].push_back(
+							    {name->second,
+							     std::get<file_ref>(it->second).path});
+					}
+
+					auto const depth = unit[index].depth;
+					auto& imports = result.imports[it->second];
+					for (auto child = index + 1;
+					     child < unit.size() && unit[child].depth > depth;
+					     ++child) {
+						if (unit[child].depth != depth + 1) continue;
+						auto found = units.find(unit[child].file);
+						if (found != units.end())
+							imports.push_back(found->second);
+					}
+				}
+			}
+
+			for (auto& [_, deps] : result.by_source)
+				sort_unique(deps);
+			for (auto& [_, deps] : result.imports)
+				sort_unique(deps);
+			return result;
+		}
+
+		// Sources outside of any module, importing nothing (header units
+		// included), which may share a translation unit or a compiler
+		// process with others.
+		std::set<symbol> independent_sources(build_info const& build,
+		                                     promoted_headers const& promoted) {
+			std::set<symbol> result{};
+			auto const it = build.modules.find(mod_name{});
+			if (it == build.modules.end()) return result;
+
+			for (auto const& source : it->second.sources) {
+				if (build.imports.count(source)) continue;
+				auto const path = std::filesystem::path{build.source_dir} /
+				                  str(source);
+				auto const units = promoted.by_source.find(
+				    path.lexically_normal().generic_u8string());
+				if (units != promoted.by_source.end() &&
+				    !units->second.empty())
+					continue;
+				result.insert(source);
+			}
+			return result;
+		}
+
+		// Independent sources of a project, batched for unity units; a
+		// batch of one is left out, as the source compiles as it is.
+		std::vector<std::vector<project_info::source const*>> unity_batches(
+		    build_info const& build,
+		    project_info const& info,
+		    std::set<symbol> const& independent,
+		    size_t max_sources,
+		    std::uint64_t max_bytes) {
+			std::vector<std::vector<project_info::source const*>> result{};
+			if (!max_sources && !max_bytes) return result;
+
+			std::vector<project_info::source const*> batch{};
+			std::uint64_t bytes{};
+			auto const close = [&] {
+				if (batch.size() > 1) result.push_back(std::move(batch));
+				batch.clear();
+				bytes = 0;
+			};
+
+			for (auto const& source : info.sources) {
+				if (!source.unity || !independent.count(source.path))
+					continue;
+
+				std::error_code ec{};
+				auto const size = std::filesystem::file_size(
+				    std::filesystem::path{build.source_dir} /
+				        str(source.path),
+				    ec);
+				if (!batch.empty() && max_bytes && bytes + size > max_bytes)
+					close();
+				batch.push_back(&source);
+				bytes += ec ? 0 : size;
+				if (batch.size() == max_sources) close();
+			}
+			close();
+			return result;
+		}
+
+		// The command of COMPILE, without the object and the depfile it
+		// names, nor the options naming them; run for a whole batch, the
+		// compiler names these after each source.
+		templated_string without_outputs(templated_string const& command) {
+			templated_string result{};
+			result.reserve(command.size());
+			for (auto const& chunk : command) {
+				auto const* name = std::get_if<var>(&chunk);
+				if (!name || (*name != var::OUTPUT && *name != var::DEPFILE)) {
+					result.push_back(chunk);
+					continue;
+				}
+				if (result.empty()) continue;
+				auto* text = std::get_if<std::string>(&result.back());
+				if (!text) continue;
+				for (auto const option : {" -o "sv, " -MF "sv}) {
+					if (!text->ends_with(option)) continue;
+					text->resize(text->size() - option.size());
+					break;
+				}
+			}
+			return result;
+		}
+
+		// Independent sources of a project, batched for one compiler
+		// process each, up to `max_bytes` of sources. The compiler writes
+		// the objects where it runs, named after the sources, so the stems
+		// in `shared_stems`, used by more than one source of the build, are
+		// left out. So are the sources over the budget by themselves, and
+		// the batches of one.
+		std::vector<std::vector<project_info::source const*>> compile_batches(
+		    build_info const& build,
+		    project_info const& info,
+		    std::set<symbol> const& independent,
+		    std::set<symbol> const& in_unity,
+		    std::set<std::u8string> const& shared_stems,
+		    std::uint64_t max_bytes) {
+			std::vector<std::vector<project_info::source const*>> result{};
+			if (!max_bytes) return result;
+
+			std::vector<project_info::source const*> batch{};
+			std::uint64_t bytes{};
+			auto const close = [&] {
+				if (batch.size() > 1) result.push_back(std::move(batch));
+				batch.clear();
+				bytes = 0;
+			};
+
+			for (auto const& source : info.sources) {
+				auto const path = std::filesystem::path{build.source_dir} /
+				                  str(source.path);
+				if (!independent.count(source.path) ||
+				    in_unity.count(source.path) ||
+				    shared_stems.count(path.stem().generic_u8string()))
+					continue;
+
+				std::error_code ec{};
+				auto const size = std::filesystem::file_size(path, ec);
+				if (ec || size > max_bytes) continue;
+				if (bytes + size > max_bytes) close();
+				batch.push_back(&source);
+				bytes += size;
+			}
+			close();
+			return result;
+		}
+
+		// Rewritten only when the list changes, the unit being an input
+		// of its edge.
+		bool write_unity_source(
+		    std::filesystem::path const& path,
+		    build_info const& build,
+		    std::vector<project_info::source const*> const& batch) {
+			std::string text{};
+			for (auto const* source : batch) {
+				auto const file = std::filesystem::path{build.source_dir} /
+				                  str(source->path);
+				text.append("#include \""sv);
+				text.append(as_sv(file.generic_u8string()));
+				text.append("\"\n"sv);
+			}
+
+			auto const current = fs::fopen(path, "rb").read();
+			if (std::string_view{current.data(), current.size()} == text)
+				return true;
+
+			std::error_code ec{};
+			std::filesystem::create_directories(path.parent_path(), ec);
+			auto file = fs::fopen(path, "wb");
+			if (ec || !file || file.store(text.data(), text.size()) !=
+			                       text.size()) {
+				std::cerr << "c++modules: warning: cannot write "
+				          << as_sv(path.generic_u8string()) << '\n';
+				return false;
+			}
+			return true;
+		}
+
+		struct merge_group {
+			mod_name module{};
+			std::vector<project_info::source const*> sources{};
+		};
+
+		// Implementation units of the modules of a project, in up to
+		// `count` groups for each module and directory; the merged unit
+		// finds the headers of its sources through -iquote, so all of them
+		// have to be in the same place. Units listed in "no-unity", or not
+		// laid out the way cxx::split_unit expects, are left out, as is a
+		// group of one.
+		std::vector<merge_group> merge_groups(build_info const& build,
+		                                      project_info const& info,
+		                                      size_t count) {
+			std::vector<merge_group> result{};
+			if (!count) return result;
+
+			std::map<symbol, mod_name> module_of{};
+			for (auto const& [name, mod] : build.modules) {
+				if (name.empty() || name.part != symbol::empty) continue;
+				for (auto const& source : mod.sources)
+					module_of[source] = name;
+			}
+
+			std::map<std::pair<mod_name, std::u8string>,
+			         std::vector<project_info::source const*>>
+			    candidates{};
+			for (auto const& source : info.sources) {
+				auto const it = module_of.find(source.path);
+				if (!source.unity || it == module_of.end()) continue;
+
+				auto const path = std::filesystem::path{build.source_dir} /
+				                  str(source.path);
+				auto const text = fs::fopen(path, "rb").read();
+				auto const parts = cxx::split_unit(
+				    std::string_view{text.data(), text.size()});
+				if (!parts || as_u8sv(parts->module) != it->second.toString())
+					continue;
+
+				candidates[{it->second,
+				            path.parent_path().generic_u8string()}]
+				    .push_back(&source);
+			}
+
+			for (auto const& [key, sources] : candidates) {
+				auto const size = (sources.size() + count - 1) / count;
+				for (size_t index = 0; index < sources.size(); ++index) {
+					if (index % size == 0) result.push_back({key.first});
+					result.back().sources.push_back(sources[index]);
+				}
+			}
+			std::erase_if(result, [](merge_group const& group) {
+				return group.sources.size() < 2;
+			});
+			return result;
+		}
+
+		void add_unique(std::vector<artifact>& list,
+		                std::vector<artifact> const& items) {
+			for (auto const& item : items) {
+				if (std::find(list.begin(), list.end(), item) == list.end())
+					list.push_back(item);
+			}
+		}
+
+		// edges for the project sources, or the units merged from them, as
+		// opposed to the header units and the standard modules
+		bool builds_project_source(target const& tgt) {
+			if (tgt.inputs.expl.empty()) return false;
+			auto const& source = tgt.inputs.expl.front();
+			if (!std::holds_alternative<file_ref>(source)) return false;
+			auto const type = std::get<file_ref>(source).type;
+			return type == file_ref::input || type == file_ref::output;
+		}
+
+		// Interfaces imported by the interfaces among `inputs`, directly
+		// or not; compilers reading an interface may need them too.
+		std::vector<artifact> indirect_imports(
+		    build_info const& build,
+		    env::binary_interface const& bin,
+		    std::vector<artifact> const& inputs) {
+			std::set<mod_name> seen{};
+			std::vector<mod_name> pending{};
+			for (auto const& input : inputs) {
+				if (!std::holds_alternative<mod_ref>(input)) continue;
+				auto const& name = std::get<mod_ref>(input).mod;
+				if (seen.insert(name).second) pending.push_back(name);
+			}
+
+			std::vector<artifact> result{};
+			while (!pending.empty()) {
+				auto const name = pending.back();
+				pending.pop_back();
+
+				auto next = bin.std_deps(name);
+				auto it = build.modules.find(name);
+				if (it != build.modules.end())
+					next.insert(next.end(), it->second.req.begin(),
+					            it->second.req.end());
+				for (auto const& dep : next) {
+					// header units name their own dependencies by path
+					auto const& module = str(dep.module);
+					if (!module.empty() &&
+					    (module.front() == u8'<' || module.front() == u8'"'))
+						continue;
+					if (!seen.insert(dep).second) continue;
+					pending.push_back(dep);
+					result.push_back(mod_ref{dep, bin.as_interface(dep)});
+				}
+			}
+			return result;
+		}
+
+		// The same build, with each project interface written by the edge
+		// compiling its object; the EMIT_BMI edges of the project sources
+		// are folded into their COMPILE edges. A side-effect compiler
+		// needs no flags for that.
+		std::vector<target> in_one_phase(std::vector<target> const& targets,
+		                                 env::binary_interface const& bin) {
+			rule_name const emit_bmi{rule_type::EMIT_BMI};
+			rule_name const compile{rule_type::COMPILE};
+
+			std::map<artifact, target const*> interfaces{};
+			for (auto const& tgt : targets) {
+				if (tgt.rule != emit_bmi || tgt.inputs.expl.size() != 1 ||
+				    !std::holds_alternative<mod_ref>(tgt.main_output))
+					continue;
+				if (builds_project_source(tgt))
+					interfaces[tgt.inputs.expl.front()] = &tgt;
+			}
+
+			std::vector<target> result{};
+			result.reserve(targets.size() - interfaces.size());
+			for (auto const& tgt : targets) {
+				if (tgt.rule == emit_bmi && tgt.inputs.expl.size() == 1) {
+					auto it = interfaces.find(tgt.inputs.expl.front());
+					if (it != interfaces.end() && it->second == &tgt)
+						continue;
+				}
+
+				auto& copy = result.emplace_back(tgt);
+				if (copy.rule != compile || copy.inputs.expl.empty())
+					continue;
+				auto it = interfaces.find(copy.inputs.expl.front());
+				if (it == interfaces.end()) continue;
+
+				auto const& bmi = *it->second;
+				auto const& mod = std::get<mod_ref>(bmi.main_output).mod;
+				copy.outputs.impl.push_back(bmi.main_output);
+				copy.edge = mod.toString();
+				add_unique(copy.inputs.impl, bmi.inputs.impl);
+				if (auto flags = bin.module_output(mod); !flags.empty())
+					copy.vars.push_back({"MODULE_OUTPUT"s, std::move(flags)});
+			}
+			return result;
+		}
+	}  // namespace
+
 	std::vector<templated_string> compiler::commands_for(rule_type type) {
 		return commands_.get(type);
 	}
 
+	dep_format compiler::deps_for(rule_type type) {
+		auto it = deps_.find(type);
+		return it == deps_.end() ? dep_format::none : it->second;
+	}
+
 	void compiler::mapout(build_info const& build, generator& gen) {
 		std::vector<target> targets;
 
@@ -21,22 +424,198 @@ namespace xml {
 		auto ids = register_projects(build, gen);
 
 		auto const standalone_bmi = bin_.standalone_interface();
+		// side-effect compilers with an interface-only command get their
+		// interfaces from EMIT_BMI, so the importers do not wait for the
+		// code generation of the interface units
+		auto const interface_only = !standalone_bmi &&
+		                            bin_.redirects_interfaces() &&
+		                            !commands_.get(rule_type::EMIT_BMI).empty();
+		// objects of those interface units, written with the interface
+		// sent elsewhere
+		std::map<artifact, mod_name> redirected{};
+		auto const promoted = promote(build, promoted_headers_, bin_);
+		static std::vector<artifact> const no_units{};
+		auto const independent = independent_sources(build, promoted);
+
+		// the batches run the command of COMPILE, with more sources
+		auto const batch_bytes =
+		    !tool_.empty() && commands_.get(rule_type::COMPILE).size() == 1
+		        ? batch_bytes_
+		        : 0;
+		std::set<std::u8string> shared_stems{};
+		if (batch_bytes) {
+			std::set<std::u8string> stems{};
+			for (auto const& [_, info] : build.projects) {
+				for (auto const& source : info.sources) {
+					auto stem = std::filesystem::path{str(source.path)}
+					                .stem()
+					                .generic_u8string();
+					if (!stems.insert(stem).second)
+						shared_stems.insert(std::move(stem));
+				}
+			}
+		}
+
+		// project source -> other names of the header units it includes
+		std::map<artifact, env::header_names const*> header_names{};
 
 		rule_types rules_needed{};
+		// linked targets, waiting for objects of the standard modules
+		std::vector<std::pair<size_t, project const*>> linked{};
 		for (auto const& [prj, info] : build.projects) {
 			auto const setup_id = get_setup_id(prj.name, ids);
 
-			for (auto const& filename : info.sources) {
+			auto const batches = unity_batches(
+			    build, info, independent, unity_sources_, unity_bytes_);
+			// objects replaced by the objects of unity and merged units
+			std::set<artifact> unified{};
+			std::set<symbol> in_unity{};
+			std::vector<artifact> unity_objects{};
+			for (size_t index = 0; index < batches.size(); ++index) {
+				auto name = u8"unity-"s;
+				name.append(as_u8sv(std::to_string(index + 1)));
+				name.append(u8".cc"sv);
+				auto const path = std::filesystem::path{build.binary_dir} /
+				                  u8"c++modules"sv / u8"unity"sv / prj.name /
+				                  name;
+				if (!write_unity_source(path, build, batches[index]))
+					continue;
+
+				rules_needed.set(rule_type::COMPILE);
+				auto const output =
+				    mods.object.modify(u8"c++modules-" + name);
+				target object{
+				    rule_type::COMPILE,
+				    file_ref{setup_id, output.generic_u8string()}};
+				object.inputs.expl.push_back(file_ref{
+				    setup_id, path.generic_u8string(), file_ref::external});
+				for (auto const* source : batches[index]) {
+					auto const& filename = str(source->filename);
+					object.inputs.impl.push_back(
+					    file_ref{setup_id, filename, file_ref::input});
+					in_unity.insert(source->path);
+					unified.insert(file_ref{
+					    setup_id,
+					    mods.object.modify(filename).generic_u8string()});
+				}
+				unity_objects.push_back(object.main_output);
+				targets.push_back(std::move(object));
+			}
+
+			std::map<mod_name, size_t> merged_count{};
+			auto const groups = merge_groups(
+			    build, info, tool_.empty() ? 0 : merged_units_);
+			for (auto const& group : groups) {
+				auto name = u8"c++modules-"s + group.module.toString();
+				name.push_back(u8'-');
+				name.append(
+				    as_u8sv(std::to_string(++merged_count[group.module])));
+				name.append(u8".cc"sv);
+				file_ref const merged{setup_id, name};
+
+				target merge{"merge-units"s, merged};
+				rules_needed.set(rule_type::COMPILE);
+				target object{
+				    rule_type::COMPILE,
+				    file_ref{setup_id,
+				             mods.object.modify(name).generic_u8string()}};
+				object.inputs.expl.push_back(merged);
+				for (auto const* source : group.sources) {
+					auto const& filename = str(source->filename);
+					auto const srcfile =
+					    (info.subdir / filename).generic_u8string();
+					merge.inputs.expl.push_back(
+					    file_ref{setup_id, filename, file_ref::input});
+
+					if (auto it = build.imports.find(source->path);
+					    it != build.imports.end()) {
+						for (auto const& import : it->second) {
+							auto art =
+							    bin_.from_module(includes_, srcfile, import);
+							if (art) add_unique(object.inputs.impl, {*art});
+						}
+					}
+					auto const units = promoted.by_source.find(
+					    (std::filesystem::path{build.source_dir} / srcfile)
+					        .lexically_normal()
+					        .generic_u8string());
+					if (units != promoted.by_source.end())
+						add_unique(object.inputs.impl, units->second);
+
+					unified.insert(file_ref{
+					    setup_id,
+					    mods.object.modify(filename).generic_u8string()});
+				}
+
+				// quoted #includes are looked up next to the merged unit
+				auto const dir = (std::filesystem::path{build.source_dir} /
+				                  str(group.sources.front()->path))
+				                     .parent_path();
+				object.vars.push_back(
+				    {"CXXFLAGS"s,
+				     u8"$CXXFLAGS -iquote " + dir.generic_u8string()});
+
+				unity_objects.push_back(object.main_output);
+				targets.push_back(std::move(merge));
+				targets.push_back(std::move(object));
+			}
+
+			// objects built by compiler processes shared with others
+			std::set<artifact> batched{};
+			auto const compiles = compile_batches(
+			    build, info, independent, in_unity, shared_stems, batch_bytes);
+			for (size_t index = 0; index < compiles.size(); ++index) {
+				target batch{"cc-batch"s, {}};
+				for (auto const* source : compiles[index]) {
+					auto const& filename = str(source->filename);
+					file_ref const object{
+					    setup_id,
+					    mods.object.modify(filename).generic_u8string()};
+					if (batch.inputs.expl.empty())
+						batch.main_output = object;
+					else
+						batch.outputs.expl.push_back(object);
+					batch.inputs.expl.push_back(
+					    file_ref{setup_id, filename, file_ref::input});
+					batched.insert(object);
+				}
+
+				auto name = u8"batch-"s;
+				name.append(as_u8sv(std::to_string(index + 1)));
+				name.append(u8".d"sv);
+				auto const depfile = std::filesystem::path{build.binary_dir} /
+				                     u8"c++modules"sv / u8"batch"sv /
+				                     prj.name / name;
+				batch.vars.push_back({"depfile"s, depfile.generic_u8string()});
+				targets.push_back(std::move(batch));
+			}
+
+			for (auto const& source : info.sources) {
+				auto const& filename = str(source.filename);
 				auto const srcfile =
 				    (info.subdir / filename).generic_u8string();
 				auto const objfile = mods.object.modify(filename).generic_u8string();
 
-				auto const mods_it = build.imports.find(srcfile);
-				auto const iface_it = build.exports.find(srcfile);
+				auto const mods_it = build.imports.find(source.path);
+				auto const iface_it = build.exports.find(source.path);
 
 				auto const has_modules = mods_it != build.imports.end();
 				auto const is_interface = iface_it != build.exports.end();
 
+				auto const fullpath =
+				    (std::filesystem::path{build.source_dir} / srcfile)
+				        .lexically_normal()
+				        .generic_u8string();
+				auto const units_it = promoted.by_source.find(fullpath);
+				auto const& header_units = units_it == promoted.by_source.end()
+				                               ? no_units
+				                               : units_it->second;
+				if (auto it = promoted.names.find(fullpath);
+				    it != promoted.names.end()) {
+					header_names[file_ref{setup_id, filename,
+					                      file_ref::input}] = &it->second;
+				}
+
 				{
 					target source{
 					    {},
@@ -44,8 +623,11 @@ namespace xml {
 					};
 					targets.push_back(std::move(source));
 				}
+				if (unified.count(file_ref{setup_id, objfile}) ||
+				    batched.count(file_ref{setup_id, objfile}))
+					continue;
 
-				if (standalone_bmi && is_interface) {
+				if ((standalone_bmi || interface_only) && is_interface) {
 					rules_needed.set(rule_type::EMIT_BMI);
 					target bmi{rule_type::EMIT_BMI,
 					           mod_ref{iface_it->second,
@@ -60,9 +642,10 @@ namespace xml {
 							auto art =
 							    bin_.from_module(includes_, srcfile, req);
 							if (art)
-								bmi.inputs.order.push_back(std::move(*art));
+								bmi.inputs.impl.push_back(std::move(*art));
 						}
 					}
+					add_unique(bmi.inputs.impl, header_units);
 					targets.push_back(std::move(bmi));
 				}
 
@@ -70,7 +653,7 @@ namespace xml {
 					rules_needed.set(rule_type::COMPILE);
 					target object{rule_type::COMPILE,
 					              file_ref{setup_id, objfile}};
-					if (!standalone_bmi && is_interface) {
+					if (!standalone_bmi && !interface_only && is_interface) {
 						object.outputs.impl.push_back(
 						    mod_ref{iface_it->second,
 						            bin_.as_interface(iface_it->second)});
@@ -84,26 +667,164 @@ namespace xml {
 							auto art =
 							    bin_.from_module(includes_, srcfile, import);
 							if (art)
-								object.inputs.order.push_back(std::move(*art));
+								object.inputs.impl.push_back(std::move(*art));
 						}
 					}
+					add_unique(object.inputs.impl, header_units);
+
+					if (interface_only && is_interface)
+						redirected[object.main_output] = iface_it->second;
 
 					targets.push_back(std::move(object));
 				}
 			}
 
 			{
-				auto library = create_project_target(build, prj, info, ids);
+				auto library = create_project_target(prj, info, ids);
+				if (!unity_objects.empty()) {
+					auto& objects = library.inputs.expl;
+					auto const is_unified = [&](artifact const& obj) {
+						return unified.count(obj) != 0;
+					};
+					auto const first = std::find_if(
+					    objects.begin(), objects.end(), is_unified);
+					objects.insert(first, unity_objects.begin(),
+					               unity_objects.end());
+					std::erase_if(objects, is_unified);
+				}
 				if (std::holds_alternative<rule_type>(library.rule)) {
 					rules_needed.set(std::get<rule_type>(library.rule));
 				}
+				if (prj.type != project::static_lib)
+					linked.push_back({targets.size(), &prj});
 				targets.push_back(std::move(library));
 			}
 		}
 
+		// the standard modules are known only after all the sources
+		for (auto const& [index, prj] : linked) {
+			auto imports = build.projects.at(*prj).imports;
+			for (auto const& next : build.projects.at(*prj).link_line) {
+				auto it = build.projects.find(next);
+				if (it == build.projects.end()) continue;
+				imports.insert(imports.end(), it->second.imports.begin(),
+				               it->second.imports.end());
+			}
+			add_unique(targets[index].inputs.expl, bin_.std_objects(imports));
+		}
+
 		bin_.add_targets(targets, rules_needed);
 
+		auto const can_merge =
+		    standalone_bmi ? bin_.writes_module_output() : interface_only;
+		auto const phases = can_merge ? bmi_phases_ : bmi_phases::two;
+		std::vector<target> combined{};
+		if (phases != bmi_phases::two)
+			combined = in_one_phase(targets, bin_);
+
+		// every edge compiling a project source gets a module map of its
+		// own, named after its main output, in the binary dir
+		auto const maps = std::filesystem::path{u8"c++modules"sv} / u8"maps"sv;
+		std::map<size_t, std::u8string> projects{};
+		for (auto const& [name, id] : ids)
+			projects[id] = name;
+		auto const map_stem = [&](artifact const& output) {
+			if (std::holds_alternative<mod_ref>(output))
+				return maps / std::get<mod_ref>(output).path;
+			auto const& ref = std::get<file_ref>(output);
+			return maps / projects[ref.prj] / ref.path;
+		};
+
+		auto const add_module_map = [&](target& tgt) {
+			auto stem = map_stem(tgt.main_output);
+			std::optional<mod_ref> exported{};
+			if (std::holds_alternative<mod_ref>(tgt.main_output))
+				exported = std::get<mod_ref>(tgt.main_output);
+			for (auto const& output : tgt.outputs.impl) {
+				if (std::holds_alternative<mod_ref>(output))
+					exported = std::get<mod_ref>(output);
+			}
+
+			auto it = redirected.find(tgt.main_output);
+			if (!exported && it != redirected.end()) {
+				// the importers read the interface built by EMIT_BMI
+				stem += u8".object"sv;
+				auto bmi = stem;
+				bmi += std::filesystem::path{bin_.as_interface(it->second)}
+				           .extension();
+				exported = mod_ref{it->second, bmi.generic_u8string()};
+			}
+
+			static env::header_names const no_names{};
+			auto const names = header_names.find(tgt.inputs.expl.front());
+
+			auto imports = tgt.inputs.impl;
+			add_unique(imports, indirect_imports(build, bin_, imports));
+			bin_.module_map(
+			    tgt, stem, imports, exported,
+			    names == header_names.end() ? no_names : *names->second);
+		};
+
+		for (auto* list : {&targets, &combined}) {
+			for (auto& tgt : *list) {
+				if (!std::holds_alternative<rule_type>(tgt.rule)) continue;
+				auto const type = std::get<rule_type>(tgt.rule);
+				if (type == rule_type::EMIT_INCLUDE) {
+					auto it = promoted.imports.find(tgt.main_output);
+					if (it != promoted.imports.end())
+						add_unique(tgt.inputs.impl, it->second);
+				}
+				if (type != rule_type::COMPILE &&
+				    type != rule_type::EMIT_BMI &&
+				    type != rule_type::EMIT_INCLUDE)
+					continue;
+				if (type != rule_type::EMIT_INCLUDE &&
+				    builds_project_source(tgt)) {
+					add_module_map(tgt);
+					continue;
+				}
+				auto flags = bin_.module_file_flags(tgt.inputs.impl);
+				if (!flags.empty())
+					tgt.vars.push_back({"MODULE_FILES"s, std::move(flags)});
+			}
+		}
+
 		add_rules(rules_needed, gen);
+		auto const uses = [&](std::string const& name) {
+			return std::any_of(
+			    targets.begin(), targets.end(),
+			    [&](target const& tgt) { return tgt.rule == rule_name{name}; });
+		};
+		if (uses("merge-units"s)) {
+			gen.add_rule({"merge-units"s,
+			              {{as_str(tool_) + " merge-units "s, var::OUTPUT,
+			                " "s, var::INPUT}},
+			              {"Merging CXX module units "s, var::OUTPUT}});
+		}
+		if (uses("cc-batch"s)) {
+			auto const compile =
+			    without_outputs(commands_.get(rule_type::COMPILE).front());
+			// the depfile is set by each edge, for its first object
+			templated_string command{
+			    as_str(tool_) + " cc-batch --depfile "s,
+			    named_var{"depfile"s},
+			    " "s,
+			    var::INPUT,
+			    " --objects "s,
+			    var::OUTPUT,
+			    " -- "s};
+			command.insert(command.end(), compile.begin(), compile.end());
+			gen.add_rule({"cc-batch"s,
+			              {std::move(command)},
+			              {"Building CXX objects "s, var::OUTPUT},
+			              deps_for(rule_type::COMPILE)});
+		}
+		if (phases == bmi_phases::one) {
+			gen.set_targets(std::move(combined));
+			return;
+		}
 		gen.set_targets(std::move(targets));
+		if (phases == bmi_phases::automatic)
+			gen.add_variant(std::move(combined));
 	}
 }  // namespace xml
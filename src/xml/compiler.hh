@@ -9,17 +9,21 @@ namespace xml {
 	struct compiler : ::compiler {
 		compiler(env::include_locator&& includes,
 		         env::binary_interface&& bin,
-		         env::command_list&& commands)
+		         env::command_list&& commands,
+		         std::map<rule_type, dep_format> const& deps)
 		    : includes_{std::move(includes)}
 		    , bin_{std::move(bin)}
-		    , commands_{std::move(commands)} {}
+		    , commands_{std::move(commands)}
+		    , deps_{deps} {}
 
 		void mapout(build_info const& build, generator& gen) override;
 		std::vector<templated_string> commands_for(rule_type) override;
+		dep_format deps_for(rule_type) override;
 
 	private:
 		env::include_locator includes_;
 		env::binary_interface bin_;
 		env::command_list commands_;
+		std::map<rule_type, dep_format> deps_;
 	};
 }  // namespace xml
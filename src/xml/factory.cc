@@ -1,4 +1,5 @@
 #include "xml/factory.hh"
+#include <base/digest.hh>
 #include <charconv>
 #include <env/path.hh>
 #include <xml/compiler.hh>
@@ -16,6 +17,57 @@ namespace xml {
 
 			return major;
 		}
+
+		// Placeholders by name, flags by the values the shared edges are
+		// given; the number of an enumerator could change under them.
+		std::string var_key(var name) {
+			std::string result{};
+			switch (name) {
+#define CASE(NAME)              \
+	case var::NAME:             \
+		result = #NAME##sv;     \
+		break;
+				VAR(CASE)
+#undef CASE
+			}
+			result.push_back('=');
+			result.append(
+			    as_sv(env::binary_interface::std_flags(name)));
+			return result;
+		}
+
+		// One directory per compiler build and the commands it is called
+		// with: anything else could give an incompatible interface.
+		std::filesystem::path std_cache_dir(
+		    std::u8string_view path,
+		    std::string_view id,
+		    std::string_view version,
+		    env::command_list const& commands) {
+			auto const root = env::user_cache_dir();
+			if (root.empty()) return {};
+
+			digest key{};
+			key.update(path);
+			key.update("\0"sv);
+			key.update(id);
+			key.update("\0"sv);
+			key.update(version);
+			for (auto const rule : {rule_type::EMIT_BMI, rule_type::COMPILE}) {
+				for (auto const& command : commands.get(rule)) {
+					key.update("\n"sv);
+					for (auto const& arg : command) {
+						key.update(" "sv);
+						if (std::holds_alternative<std::string>(arg))
+							key.update(std::get<std::string>(arg));
+						else if (std::holds_alternative<named_var>(arg))
+							key.update(std::get<named_var>(arg).value);
+						else
+							key.update(var_key(std::get<var>(arg)));
+					}
+				}
+			}
+			return root / u8"std"sv / as_u8sv(key.hex().substr(0, 16));
+		}
 	}  // namespace
 
 	factory::factory(std::filesystem::path&& filename,
@@ -25,7 +77,7 @@ namespace xml {
 	std::unique_ptr<::compiler> factory::create(
 	    logger& log,
 	    std::u8string_view path,
-	    std::string_view,
+	    std::string_view id,
 	    std::string_view version) const {
 		auto const paths =
 		    env::paths::parser{path, cfg.ident.exe, get_version_major(version)}
@@ -41,7 +93,32 @@ namespace xml {
 
 		env::binary_interface bin{cfg.bmi_decl.supports_parition,
 		                          cfg.bmi_decl.type == bmi_decl::direct,
-		                          cfg.bmi_decl.dirname, cfg.bmi_decl.ext};
+		                          cfg.bmi_decl.dirname, cfg.bmi_decl.ext,
+		                          cfg.bmi_decl.module_file_flag,
+		                          cfg.bmi_decl.mapper_flag};
+
+		auto const& since = cfg.bmi_decl.module_output_since;
+		if (since.empty() ||
+		    get_version_major(version) >= get_version_major(as_sv(since)))
+			bin.set_module_output(cfg.bmi_decl.module_output_flag,
+			                      cfg.bmi_decl.reduced_bmi_flag);
+
+		env::command_list commands{paths, cfg.rules};
+
+		auto const std_cache =
+		    cfg.std_modules.empty()
+		        ? std::filesystem::path{}
+		        : std_cache_dir(path, id, version, commands);
+		if (!std_cache.empty()) {
+			std::map<mod_name, env::binary_interface::std_source> sources{};
+			for (auto const& mod : cfg.std_modules) {
+				auto& source = sources[mod_name{mod.name}];
+				source.include = mod.include;
+				if (!mod.path.empty())
+					source.path = (paths.root / mod.path).lexically_normal();
+			}
+			bin.set_std_modules(std_cache, std::move(sources));
+		}
 
 		log.output << "\n------------------------------------\n\n"sv;
 
@@ -50,11 +127,15 @@ namespace xml {
 		           << " :: " << as_sv(paths.triple)
 		           << " :: " << as_sv(cfg.ident.exe)
 		           << " :: " << as_sv(paths.suffix) << '\n'
-		           << bin << std::flush;
+		           << bin;
+		if (!std_cache.empty())
+			log.output << "    std modules: "
+			           << as_sv(std_cache.generic_u8string()) << '\n';
+		log.output << std::flush;
 
 		return std::make_unique<xml::compiler>(
-		    std::move(locator), std::move(bin),
-		    env::command_list{paths, cfg.rules});
+		    std::move(locator), std::move(bin), std::move(commands),
+		    cfg.deps);
 	}
 
 	compiler_id factory::get_compiler_id() const {
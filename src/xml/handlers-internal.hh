@@ -48,6 +48,7 @@ namespace xml {
 
 	struct rule_handler : handler_interface {
 		std::string rule_name;
+		std::string deps;
 		xml::commands commands;
 
 		void onElement(xml_config&, char const** attrs) override;
@@ -70,6 +71,10 @@ namespace xml {
 		void onElement(xml_config& cfg, char const** attrs) override;
 	};
 
+	struct std_module_handler : handler_interface {
+		void onElement(xml_config& cfg, char const** attrs) override;
+	};
+
 	struct ident_handler : handler_interface {
 		void onElement(xml_config& cfg, char const** attrs) override;
 	};
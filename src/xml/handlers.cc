@@ -108,7 +108,10 @@ namespace xml {
 	void rule_handler::onElement(xml_config&, char const** attrs) {
 		for (auto attr = attrs; *attr; attr += 2) {
 			auto const name = std::string_view{attr[0]};
-			if (name == "id"sv) rule_name.assign(attr[1]);
+			if (name == "id"sv)
+				rule_name.assign(attr[1]);
+			else if (name == "deps"sv)
+				deps.assign(attr[1]);
 		}
 	}
 
@@ -120,6 +123,7 @@ namespace xml {
 	}
 
 	void rule_handler::onStop(xml_config& cfg) {
+		if (!deps.empty()) cfg.str_deps[rule_name] = std::move(deps);
 		cfg.str_rules[std::move(rule_name)] = std::move(commands);
 	}
 
@@ -164,6 +168,31 @@ namespace xml {
 				                                : bmi_decl::direct);
 			else if (name == "partitions"sv)
 				cfg.out->bmi_decl.supports_parition = boolVal(value);
+			else if (name == "module-file-flag"sv)
+				cfg.out->bmi_decl.module_file_flag.assign(value);
+			else if (name == "mapper-flag"sv)
+				cfg.out->bmi_decl.mapper_flag.assign(value);
+			else if (name == "module-output-flag"sv)
+				cfg.out->bmi_decl.module_output_flag.assign(value);
+			else if (name == "reduced-bmi-flag"sv)
+				cfg.out->bmi_decl.reduced_bmi_flag.assign(value);
+			else if (name == "module-output-since"sv)
+				cfg.out->bmi_decl.module_output_since.assign(value);
+		}
+	}
+
+	void std_module_handler::onElement(xml_config& cfg, char const** attrs) {
+		auto& mod = cfg.out->std_modules.emplace_back();
+		for (auto attr = attrs; *attr; attr += 2) {
+			auto const name = std::string_view{attr[0]};
+			auto const value =
+			    std::u8string_view{reinterpret_cast<char8_t const*>(attr[1])};
+			if (name == "name"sv)
+				mod.name.assign(value);
+			else if (name == "include"sv)
+				mod.include.assign(value);
+			else if (name == "path"sv)
+				mod.path.assign(value);
 		}
 	}
 
@@ -194,6 +223,8 @@ namespace xml {
 			return std::make_unique<bmi_cache_handler>();
 		if (name == u8"include-dirs"sv)
 			return std::make_unique<include_dirs_handler>();
+		if (name == u8"std-module"sv)
+			return std::make_unique<std_module_handler>();
 		if (name == u8"rules"sv) return std::make_unique<rules_handler>();
 		return {};
 	}
@@ -8,6 +8,7 @@ namespace xml {
 	struct xml_config {
 		compiler_factory_config* out{};
 		std::map<std::string, commands> str_rules{};
+		std::map<std::string, std::string> str_deps{};
 	};
 
 	struct handler_interface {
@@ -94,6 +94,29 @@ namespace xml {
 		return result;
 	}
 
+	std::optional<std::map<rule_type, dep_format>> deps_from(
+	    std::map<std::string, std::string> const& deps) {
+		std::map<rule_type, dep_format> result{};
+		for (auto const& [key, value] : deps) {
+			auto const type = rule_from(key);
+			if (!type) {
+				std::cerr << "error: unknown rule: " << key << '\n';
+				return std::nullopt;
+			}
+
+			if (value == "gcc"sv)
+				result[*type] = dep_format::gcc;
+			else if (value == "msvc"sv)
+				result[*type] = dep_format::msvc;
+			else if (value != "none"sv) {
+				std::cerr << "error: unknown deps format for " << key << ": "
+				          << value << '\n';
+				return std::nullopt;
+			}
+		}
+		return result;
+	}
+
 	class parser : public xml::ExpatBase<parser> {
 		std::stack<std::unique_ptr<handler_interface>> handlers_{};
 		int ignore_depth_{0};
@@ -128,6 +151,11 @@ namespace xml {
 			if (!rules) return false;
 
 			output.rules = std::move(*rules);
+
+			auto deps = xml::deps_from(ldr.config_.str_deps);
+			if (!deps) return false;
+
+			output.deps = std::move(*deps);
 			return true;
 		}
 
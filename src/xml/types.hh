@@ -21,6 +21,21 @@ namespace xml {
 		std::u8string ext{};
 		kind type{direct};
 		bool supports_parition{true};
+		std::u8string module_file_flag{};
+		std::u8string mapper_flag{};
+		// for one-phase builds of interface units, from the major version
+		// in module_output_since on
+		std::u8string module_output_flag{};
+		std::u8string reduced_bmi_flag{};
+		std::u8string module_output_since{};
+	};
+
+	// Source of a standard library module; `include` is looked up in the
+	// system include dirs, `path` is relative to the compiler's directory.
+	struct std_module {
+		std::u8string name{};
+		std::u8string include{};
+		std::u8string path{};
 	};
 
 	struct include_dirs {
@@ -36,5 +51,7 @@ namespace xml {
 		xml::bmi_decl bmi_decl{};
 		xml::include_dirs include_dirs{};
 		std::map<rule_type, commands> rules{};
+		std::map<rule_type, dep_format> deps{};
+		std::vector<xml::std_module> std_modules{};
 	};
 }  // namespace xml
\ No newline at end of file
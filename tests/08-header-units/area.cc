@@ -0,0 +1,4 @@
+#define PARSED_AS_TEXT
+#include "shape.h"
+
+int area(shape::rect const& r) { return r.width * r.height; }
@@ -0,0 +1,11 @@
+#include <iostream>
+#include "shape.h"
+
+int area(shape::rect const& r);
+int perimeter(shape::rect const& r);
+
+int main() {
+	shape::rect const r{3, 4};
+	std::cout << "area: " << area(r) << ", perimeter: " << perimeter(r)
+	          << '\n';
+}
@@ -0,0 +1,4 @@
+#define PARSED_AS_TEXT
+#include "shape.h"
+
+int perimeter(shape::rect const& r) { return 2 * (r.width + r.height); }
@@ -0,0 +1,14 @@
+#pragma once
+
+// Compiled once, as a header unit: the translation units including it
+// import it instead, so their own macros never reach it.
+#ifdef PARSED_AS_TEXT
+static_assert(false, "shape.h was included as text, not imported");
+#endif
+
+namespace shape {
+	struct rect {
+		int width;
+		int height;
+	};
+}  // namespace shape
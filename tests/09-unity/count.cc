@@ -0,0 +1,5 @@
+#include <vector>
+
+int count(std::vector<int> const& items) {
+	return static_cast<int>(items.size());
+}
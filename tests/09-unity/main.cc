@@ -0,0 +1,12 @@
+#include <iostream>
+#include <vector>
+
+int count(std::vector<int> const& items);
+int sum(std::vector<int> const& items);
+int product(std::vector<int> const& items);
+
+int main() {
+	std::vector<int> const items{1, 2, 3, 4};
+	std::cout << "count: " << count(items) << ", sum: " << sum(items)
+	          << ", product: " << product(items) << '\n';
+}
@@ -0,0 +1,12 @@
+#include <vector>
+
+namespace {
+	int fold(std::vector<int> const& items) {
+		int result = 1;
+		for (auto item : items)
+			result *= item;
+		return result;
+	}
+}  // namespace
+
+int product(std::vector<int> const& items) { return fold(items); }
@@ -0,0 +1,13 @@
+#include <vector>
+
+namespace {
+	// the same name as in product.cc, which is left out of the unit
+	int fold(std::vector<int> const& items) {
+		int result = 0;
+		for (auto item : items)
+			result += item;
+		return result;
+	}
+}  // namespace
+
+int sum(std::vector<int> const& items) { return fold(items); }
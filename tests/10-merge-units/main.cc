@@ -0,0 +1,11 @@
+#include <iostream>
+#include <vector>
+
+import stats;
+
+int main() {
+	std::vector<int> const items{3, 1, 4, 1, 5, 9, 2, 6};
+	std::cout << "min: " << stats::min(items)
+	          << ", max: " << stats::max(items)
+	          << ", mean: " << stats::mean(items) << '\n';
+}
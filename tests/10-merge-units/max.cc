@@ -0,0 +1,11 @@
+module;
+#include <algorithm>
+#include <vector>
+
+module stats;
+
+namespace stats {
+	int max(std::vector<int> const& items) {
+		return *std::max_element(items.begin(), items.end());
+	}
+}  // namespace stats
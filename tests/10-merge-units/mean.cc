@@ -0,0 +1,12 @@
+module;
+#include <numeric>
+#include <vector>
+
+module stats;
+
+namespace stats {
+	int mean(std::vector<int> const& items) {
+		auto const sum = std::accumulate(items.begin(), items.end(), 0);
+		return sum / static_cast<int>(items.size());
+	}
+}  // namespace stats
@@ -0,0 +1,11 @@
+module;
+#include <algorithm>
+#include <vector>
+
+module stats;
+
+namespace stats {
+	int min(std::vector<int> const& items) {
+		return *std::min_element(items.begin(), items.end());
+	}
+}  // namespace stats
@@ -0,0 +1,10 @@
+module;
+#include <vector>
+
+export module stats;
+
+namespace stats {
+	export int min(std::vector<int> const& items);
+	export int max(std::vector<int> const& items);
+	export int mean(std::vector<int> const& items);
+}  // namespace stats
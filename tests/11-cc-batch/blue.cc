@@ -0,0 +1 @@
+int blue() { return 64; }
@@ -0,0 +1 @@
+int green() { return 128; }
@@ -0,0 +1,10 @@
+#include <iostream>
+
+int red();
+int green();
+int blue();
+
+int main() {
+	std::cout << "rgb(" << red() << ", " << green() << ", " << blue()
+	          << ")\n";
+}
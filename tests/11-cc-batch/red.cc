@@ -0,0 +1 @@
+int red() { return 255; }
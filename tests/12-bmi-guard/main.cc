@@ -0,0 +1,8 @@
+#include <iostream>
+
+import version;
+
+int main() {
+	std::cout << "version " << version::year << '.' << version::month
+	          << '\n';
+}
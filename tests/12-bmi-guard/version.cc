@@ -0,0 +1,9 @@
+export module version;
+
+// Saving this file without a change, or with a change to comments only,
+// rebuilds the interface. The guard then keeps the old one, so main.cc
+// is not compiled again.
+export namespace version {
+	inline constexpr int year = 2024;
+	inline constexpr int month = 5;
+}  // namespace version
@@ -13,6 +13,26 @@ suite = {
     "04-impl": "app",
     "05-strings-B": "app",
     "06-static-lib": "app/example",
+    "08-header-units": "app",
+    "09-unity": "app",
+    "10-merge-units": "app",
+    "11-cc-batch": "app",
+    "12-bmi-guard": "app",
+}
+
+# options for c++modules, for the samples of a build mode
+options = {
+    "08-header-units": ["--header-units"],
+    "09-unity": ["--unity"],
+    "10-merge-units": ["--merge-units=1"],
+    "11-cc-batch": ["--batch-compile"],
+    "12-bmi-guard": ["--bmi-guard"],
+}
+
+# a source saved again without changes after the first build, and an
+# object importing it, which must not be compiled again
+unchanged = {
+    "12-bmi-guard": ("version.cc", "app.dir/main.cc.o"),
 }
 
 __dirname__ = os.path.dirname(__file__)
@@ -41,16 +61,28 @@ def run(*args, **kwargs):
     return True
 
 
+def rebuild_unchanged(source, obj):
+    before = os.stat(obj).st_mtime_ns
+    os.utime(os.path.join('..', source))
+    if not run('ninja'):
+        return False
+    if os.stat(obj).st_mtime_ns != before:
+        print(obj, 'rebuilt after', source, 'was saved unchanged', file=sys.stderr)
+        return False
+    return True
+
+
 def run_test(dirname, application):
     print('==[   {:=<50}'.format(dirname + '   ]'))
     with cd(os.path.join(__dirname__, dirname)):
         shutil.rmtree('build', ignore_errors=True)
-        if not run(binary):
+        if not run(binary, *options.get(dirname, [])):
             return
         with cd('build'):
             run('dot', '-Tpng', '-o', 'dependencies.png', 'dependencies.dot') and \
                 run('ninja') and \
-                run(os.path.join('.', application))
+                run(os.path.join('.', application)) and \
+                (dirname not in unchanged or rebuild_unchanged(*unchanged[dirname]))
 
 
 if len(sys.argv) > 1:
@@ -0,0 +1,184 @@
+#include "test.hh"
+
+#include <base/include_graph.hh>
+#include <fs/file.hh>
+#include <chrono>
+#include <limits>
+#include <random>
+
+using namespace std::literals;
+
+namespace {
+	// Directory removed with everything in it when the test is done.
+	struct temp_dir {
+		std::filesystem::path path{};
+
+		temp_dir() {
+			path = std::filesystem::temp_directory_path() /
+			       ("c++modules-tests-" +
+			        std::to_string(std::random_device{}()));
+			std::filesystem::create_directories(path);
+		}
+		~temp_dir() {
+			std::error_code ec{};
+			std::filesystem::remove_all(path, ec);
+		}
+		temp_dir(temp_dir const&) = delete;
+		temp_dir& operator=(temp_dir const&) = delete;
+
+		std::u8string file(std::u8string_view name) const {
+			auto const result = path / name;
+			auto out = fs::fopen(result, "wb");
+			out.store("//\n", 3);
+			return result.generic_u8string();
+		}
+	};
+
+	std::vector<std::u8string> paths_of(
+	    include_graph const& graph,
+	    std::vector<include_graph::weight> const& weights) {
+		std::vector<std::u8string> result{};
+		for (auto const& item : weights)
+			result.push_back(graph.files[item.file].path);
+		return result;
+	}
+}  // namespace
+
+TEST(include_graph_round_trip) {
+	temp_dir dir{};
+	auto const unit = dir.file(u8"unit.cc"sv);
+	auto const header = dir.file(u8"header.h"sv);
+	// gone before the graph is built, so stored with the lowest mtime
+	auto const missing = (dir.path / u8"missing.h"sv).generic_u8string();
+
+	// numbers taking one to ten bytes of LEB128
+	include_graph graph{};
+	include_entry const tree[] = {
+	    {unit, 0, 0},
+	    {header, 1, 127},
+	    {missing, 300, 1ull << 40},
+	    {header, 2, ~0ull},
+	};
+	graph.add(tree);
+
+	auto const db = dir.path / u8"includes.db"sv;
+	if (!CHECK(graph.store(db))) return;
+	auto const loaded = include_graph::load(db);
+
+	if (!CHECK(loaded.files.size() == graph.files.size())) return;
+	for (size_t id = 0; id < graph.files.size(); ++id) {
+		CHECK(loaded.files[id].path == graph.files[id].path);
+		CHECK(loaded.files[id].mtime == graph.files[id].mtime);
+	}
+	CHECK(loaded.files[2].mtime == std::numeric_limits<std::int64_t>::min());
+
+	if (!CHECK(loaded.units.size() == 1)) return;
+	auto const& incs = loaded.units.front();
+	if (!CHECK(incs.size() == std::size(tree))) return;
+	for (size_t index = 0; index < incs.size(); ++index) {
+		CHECK(loaded.files[incs[index].file].path == tree[index].path);
+		CHECK(incs[index].depth == tree[index].depth);
+		CHECK(incs[index].bytes == tree[index].bytes);
+	}
+	CHECK(loaded.find(header) == 1u);
+}
+
+TEST(include_graph_rejects_broken_files) {
+	temp_dir dir{};
+	include_graph graph{};
+	include_entry const tree[] = {
+	    {dir.file(u8"unit.cc"sv), 0, 10},
+	    {dir.file(u8"header.h"sv), 1, 1000},
+	};
+	graph.add(tree);
+
+	auto const db = dir.path / u8"includes.db"sv;
+	if (!CHECK(graph.store(db))) return;
+	auto const bytes = fs::fopen(db, "rb").read();
+
+	// cut in the middle of the last number
+	{
+		auto out = fs::fopen(db, "wb");
+		out.store(bytes.data(), bytes.size() - 1);
+	}
+	auto const cut = include_graph::load(db);
+	CHECK(cut.files.empty());
+	CHECK(cut.units.empty());
+
+	CHECK(include_graph::load(dir.path / u8"none.db"sv).units.empty());
+}
+
+TEST(include_graph_heaviest) {
+	temp_dir dir{};
+	auto const a = dir.file(u8"a.h"sv);
+	auto const b = dir.file(u8"b.h"sv);
+	auto const c = dir.file(u8"c.h"sv);
+
+	// a.h includes b.h; c.h stands alone
+	include_graph graph{};
+	include_entry const first[] = {
+	    {dir.file(u8"first.cc"sv), 0, 10},
+	    {a, 1, 100},
+	    {b, 2, 50},
+	    {c, 1, 120},
+	};
+	include_entry const second[] = {
+	    {dir.file(u8"second.cc"sv), 0, 10},
+	    {a, 1, 100},
+	    {b, 2, 50},
+	};
+	graph.add(first);
+	graph.add(second);
+
+	auto const own = graph.heaviest();
+	CHECK(paths_of(graph, own) == std::vector{a, c, b});
+	if (CHECK(own.size() == 3)) {
+		CHECK(own[0].bytes == 200);
+		CHECK(own[0].units == 2);
+		CHECK(own[1].bytes == 120);
+		CHECK(own[1].units == 1);
+		CHECK(own[2].bytes == 100);
+	}
+
+	// a.h now brings b.h along
+	auto const with_includes = graph.heaviest(true);
+	CHECK(paths_of(graph, with_includes) == std::vector{a, c, b});
+	if (CHECK(with_includes.size() == 3)) {
+		CHECK(with_includes[0].bytes == 300);
+		CHECK(with_includes[1].bytes == 120);
+		CHECK(with_includes[2].bytes == 100);
+	}
+}
+
+TEST(include_graph_stale) {
+	temp_dir dir{};
+	auto const shared = dir.file(u8"shared.h"sv);
+	auto const own = dir.file(u8"own.h"sv);
+
+	include_graph graph{};
+	include_entry const first[] = {
+	    {dir.file(u8"first.cc"sv), 0, 10},
+	    {shared, 1, 10},
+	};
+	include_entry const second[] = {
+	    {dir.file(u8"second.cc"sv), 0, 10},
+	    {own, 1, 10},
+	};
+	include_entry const third[] = {
+	    {dir.file(u8"third.cc"sv), 0, 10},
+	    {shared, 1, 10},
+	};
+	graph.add(first);
+	graph.add(second);
+	graph.add(third);
+	CHECK(graph.stale().empty());
+
+	std::filesystem::path const shared_path{shared};
+	std::filesystem::last_write_time(
+	    shared_path,
+	    std::filesystem::last_write_time(shared_path) + 1s);
+	CHECK(graph.stale() == std::vector<std::uint32_t>{0, 2});
+
+	std::filesystem::remove(std::filesystem::path{own});
+	CHECK(graph.stale() == std::vector<std::uint32_t>{0, 1, 2});
+}
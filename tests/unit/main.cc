@@ -0,0 +1,52 @@
+#include "test.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+	struct test_case {
+		std::string_view name{};
+		test::test_fn fn{};
+	};
+
+	std::vector<test_case>& registry() {
+		static std::vector<test_case> tests{};
+		return tests;
+	}
+
+	bool current_failed = false;
+}  // namespace
+
+bool test::add(std::string_view name, test_fn fn) {
+	registry().push_back({name, fn});
+	return true;
+}
+
+bool test::check(bool ok, std::string_view expr, char const* file, int line) {
+	if (!ok) {
+		std::fprintf(stderr, "%s:%d: check failed: %.*s\n", file, line,
+		             static_cast<int>(expr.size()), expr.data());
+		current_failed = true;
+	}
+	return ok;
+}
+
+int main(int argc, char** argv) {
+	std::string_view const filter{argc > 1 ? argv[1] : ""};
+
+	size_t run{};
+	size_t failed{};
+	for (auto const& test : registry()) {
+		if (test.name.find(filter) == std::string_view::npos) continue;
+		current_failed = false;
+		test.fn();
+		++run;
+		if (current_failed) ++failed;
+		std::printf("%s %.*s\n", current_failed ? "FAIL" : "  ok",
+		            static_cast<int>(test.name.size()), test.name.data());
+	}
+
+	std::printf("%zu of %zu tests passed\n", run - failed, run);
+	return failed ? 1 : 0;
+}
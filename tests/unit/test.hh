@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string_view>
+
+namespace test {
+	using test_fn = void (*)();
+
+	// Adds a test to the list main.cc runs; called by TEST() before main.
+	bool add(std::string_view name, test_fn fn);
+
+	// Reports a failed check of the running test and marks it as failed;
+	// gives `ok` back.
+	bool check(bool ok, std::string_view expr, char const* file, int line);
+}  // namespace test
+
+#define TEST(NAME)                                     \
+	static void NAME();                                \
+	[[maybe_unused]] static bool const NAME##_added =  \
+	    test::add(#NAME, NAME);                        \
+	static void NAME()
+
+#define CHECK(...)                                                \
+	test::check((__VA_ARGS__) ? true : false, #__VA_ARGS__, __FILE__, \
+	            __LINE__)
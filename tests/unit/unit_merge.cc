@@ -0,0 +1,105 @@
+#include "test.hh"
+
+#include <cxx/unit_merge.hh>
+
+using namespace std::literals;
+
+namespace {
+	bool splits(std::string_view text) {
+		return cxx::split_unit(text).has_value();
+	}
+}  // namespace
+
+TEST(split_unit_with_fragment) {
+	auto const parts = cxx::split_unit(
+	    "module;\n"
+	    "#include <vector>\n"
+	    "module m;\n"
+	    "import a;\n"
+	    "\n"
+	    "int f() { return 1; }\n"sv);
+	if (!CHECK(parts)) return;
+	CHECK(parts->module == "m"sv);
+	CHECK(parts->fragment == "#include <vector>\n"sv);
+	CHECK(parts->fragment_line == 2);
+	CHECK(parts->imports == "import a;\n\n"sv);
+	CHECK(parts->imports_line == 4);
+	CHECK(parts->body == "int f() { return 1; }\n"sv);
+	CHECK(parts->body_line == 6);
+}
+
+TEST(split_unit_without_fragment) {
+	auto const parts = cxx::split_unit(
+	    "// leading comment\n"
+	    "module a.b; // trailing\n"
+	    "int x;\n"sv);
+	if (!CHECK(parts)) return;
+	CHECK(parts->module == "a.b"sv);
+	CHECK(parts->fragment.empty());
+	CHECK(parts->imports.empty());
+	CHECK(parts->body == "int x;\n"sv);
+	CHECK(parts->body_line == 3);
+}
+
+TEST(split_unit_imports_only) {
+	auto const parts = cxx::split_unit("module m;\nimport a;\n"sv);
+	if (!CHECK(parts)) return;
+	CHECK(parts->imports == "import a;\n"sv);
+	CHECK(parts->body.empty());
+}
+
+TEST(split_unit_refusals) {
+	CHECK(!splits(""sv));
+	CHECK(!splits("int x;\n"sv));
+	// interfaces and partitions are not merged
+	CHECK(!splits("export module m;\nint x;\n"sv));
+	CHECK(!splits("module m:part;\nint x;\n"sv));
+	// a declaration depending on the preprocessor
+	CHECK(!splits("module;\n#if X\nmodule m;\n#endif\nint x;\n"sv));
+	// imports and includes after the first declaration
+	CHECK(!splits("module m;\nint x;\nimport a;\n"sv));
+	CHECK(!splits("module m;\nint x;\n#include <vector>\n"sv));
+	// a comment opened among the imports, closed in the body
+	CHECK(!splits("module m;\nimport a; /* open\nint x; */ int y;\n"sv));
+}
+
+TEST(merge_units_of_one_module) {
+	auto const merged = cxx::merge_units({
+	    {"a.cc",
+	     "module;\n#include <vector>\nmodule m;\nimport x;\nint a();\n"},
+	    {"b.cc", "module m;\nint b();\n"},
+	});
+	if (!CHECK(merged)) return;
+	CHECK(*merged ==
+	      "module;\n"
+	      "#line 2 \"a.cc\"\n"
+	      "#include <vector>\n"
+	      "module m;\n"
+	      "#line 4 \"a.cc\"\n"
+	      "import x;\n"
+	      "#line 5 \"a.cc\"\n"
+	      "int a();\n"
+	      "#line 2 \"b.cc\"\n"
+	      "int b();\n"sv);
+}
+
+TEST(merge_units_escapes_paths) {
+	auto const merged = cxx::merge_units({
+	    {"dir\\\"a\".cc", "module m;\nint a();\n"},
+	});
+	if (!CHECK(merged)) return;
+	CHECK(*merged ==
+	      "module m;\n#line 2 \"dir\\\\\\\"a\\\".cc\"\nint a();\n"sv);
+}
+
+TEST(merge_units_refusals) {
+	CHECK(!cxx::merge_units({}));
+	CHECK(!cxx::merge_units({
+	    {"a.cc", "module m;\nint a();\n"},
+	    {"b.cc", "module n;\nint b();\n"},
+	}));
+	CHECK(!cxx::merge_units({
+	    {"a.cc", "module m;\nint a();\n"},
+	    {"b.cc", "module m;\nint b();\nimport x;\n"},
+	}));
+}